@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2006 Markus Fisch
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Markus Fisch nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <sys/types.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <map>
+
+#include "Arena.hh"
+
+using namespace std;
+using namespace bbdock;
+
+/**
+ * Free all buffers that are not in use
+ */
+Arena::~Arena()
+{
+	map<size_t, vector<char *> >::iterator it = unused.begin();
+	map<size_t, vector<char *> >::iterator end = unused.end();
+
+	for( ; it != end; ++it )
+		for( vector<char *>::iterator b = it->second.begin();
+			b != it->second.end(); ++b )
+			free( *b );
+}
+
+/**
+ * Return a zeroed buffer, returns 0 if there is no memory left
+ *
+ * @param size - size of buffer in bytes
+ */
+char *Arena::allocate( size_t size )
+{
+	size = align( size );
+
+	map<size_t, vector<char *> >::iterator it;
+	char *buf;
+
+	if( (it = unused.find( size )) != unused.end() &&
+		!it->second.empty() )
+	{
+		buf = it->second.back();
+		it->second.pop_back();
+	}
+	else
+	{
+		void *p;
+
+		if( posix_memalign( &p, Alignment, size ) )
+			return 0;
+
+		buf = (char *) p;
+	}
+
+	++used[size];
+	memset( buf, 0, size );
+
+	return buf;
+}
+
+/**
+ * Give a buffer back to be reused, buffers that are not likely to be
+ * needed again are freed
+ *
+ * @param buf - buffer from allocate()
+ * @param size - size of buffer in bytes as given to allocate()
+ */
+void Arena::release( char *buf, size_t size )
+{
+	if( !buf )
+		return;
+
+	size = align( size );
+
+	vector<char *> &list = unused[size];
+
+	// the last buffer of a size frees all kept ones
+	if( !--used[size] )
+	{
+		free( buf );
+
+		for( vector<char *>::iterator it = list.begin();
+			it != list.end(); ++it )
+			free( *it );
+
+		unused.erase( size );
+		used.erase( size );
+
+		return;
+	}
+
+	if( list.size() >= MaxUnused )
+	{
+		free( buf );
+		return;
+	}
+
+	list.push_back( buf );
+}
+
+/**
+ * Round up to a multiple of the alignment
+ *
+ * @param n - number of bytes
+ */
+size_t Arena::align( size_t n )
+{
+	return (n+Alignment-1)/Alignment*Alignment;
+}
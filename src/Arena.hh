@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2006 Markus Fisch
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Markus Fisch nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef bbdock_Arena_hh
+#define bbdock_Arena_hh
+
+#include <sys/types.h>
+#include <vector>
+#include <map>
+
+namespace bbdock
+{
+	/**
+	 * Arena hands out aligned pixel buffers from the allocator and
+	 * keeps up to MaxUnused released ones per size as long as there
+	 * are buffers of that size in use, so slots that get surfaces of
+	 * a common size again don't go through the allocator; buffers of
+	 * a size nobody uses anymore are freed
+	 *
+	 * @author mf@markusfisch.de
+	 * @version 0.0.2
+	 */
+	class Arena
+	{
+		public:
+			enum
+			{
+				Alignment = 64,
+				MaxUnused = 8
+			};
+
+			Arena() {}
+			virtual ~Arena();
+			virtual char *allocate( size_t );
+			virtual void release( char *, size_t );
+
+		private:
+			std::map<size_t, std::vector<char *> > unused;
+			std::map<size_t, size_t> used;
+
+			static size_t align( size_t );
+	};
+}
+
+#endif
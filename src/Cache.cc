@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2006 Markus Fisch
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Markus Fisch nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <time.h>
+#include <string>
+
+#include "Cache.hh"
+
+using namespace std;
+using namespace bbdock;
+
+const char Cache::Magic[8] = { 'b', 'b', 'd', 'o', 'c', 'k', 0, 4 };
+pthread_mutex_t Cache::mutex = PTHREAD_MUTEX_INITIALIZER;
+bool Cache::pruned = false;
+
+/**
+ * Return image from cache or decode, scale and cache it
+ *
+ * @param file - image file
+ * @param maxwidth - maximum width of image
+ * @param maxheight - maximum height of image
+ * @param scale - scale factor (optional)
+ * @param status - receives the status of the file the image is
+ *                 from (optional)
+ */
+Image *Cache::load( const string &file, int maxwidth, int maxheight, 
+	float scale, struct stat *status )
+{
+	struct stat st;
+
+	if( stat( file.c_str(), &st ) < 0 )
+		throw "Invalid image file !";
+
+	if( status )
+		*status = st;
+
+	Image *image;
+
+	if( (image = find( file, st, maxwidth, maxheight, scale )) )
+		return image;
+
+	{
+		Image *decoded = new Image( file );
+
+		try
+		{
+			image = decoded->fit( maxwidth, maxheight, scale );
+		}
+		catch( ... )
+		{
+			decoded->release();
+			throw;
+		}
+
+		decoded->release();
+	}
+
+	store( file, st, maxwidth, maxheight, scale, *image );
+
+	return image;
+}
+
+/**
+ * Map cached image, returns 0 if there is no valid cache entry
+ *
+ * @param file - image file
+ * @param st - status of image file
+ * @param maxwidth - maximum width of image
+ * @param maxheight - maximum height of image
+ * @param scale - scale factor
+ */
+Image *Cache::find( const string &file, const struct stat &st, 
+	int maxwidth, int maxheight, float scale )
+{
+	string path = getPath( file, maxwidth, maxheight, scale );
+	int fd;
+
+	if( path.empty() ||
+		(fd = open( path.c_str(), O_RDONLY )) < 0 )
+		return 0;
+
+	struct stat cst;
+	void *map = MAP_FAILED;
+
+	if( !fstat( fd, &cst ) &&
+		cst.st_size >= (off_t) sizeof( Header ) )
+		map = mmap( 0, cst.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+
+	if( map == MAP_FAILED )
+	{
+		close( fd );
+		return 0;
+	}
+
+	const Header *h = (const Header *) map;
+
+	// check the dimensions first to make sure the size can't overflow
+	if( memcmp( h->magic, Magic, sizeof( Magic ) ) ||
+		h->maxwidth != (unsigned int) maxwidth ||
+		h->maxheight != (unsigned int) maxheight ||
+		h->scale != scale ||
+		h->pathlength != file.length() ||
+		!h->width ||
+		!h->height ||
+		h->width > h->maxwidth ||
+		h->height > h->maxheight ||
+		(size_t) cst.st_size != align( sizeof( Header )+h->pathlength )+
+			(size_t) h->width*h->height*4 ||
+		h->mtime != (long long) st.st_mtim.tv_sec ||
+		h->mtimensec != (long long) st.st_mtim.tv_nsec ||
+		h->ctime != (long long) st.st_ctim.tv_sec ||
+		h->ctimensec != (long long) st.st_ctim.tv_nsec ||
+		h->size != (long long) st.st_size ||
+		h->inode != (long long) st.st_ino ||
+		memcmp( (const char *) map+sizeof( Header ), file.c_str(), 
+			h->pathlength ) )
+	{
+		close( fd );
+		munmap( map, cst.st_size );
+		return 0;
+	}
+
+	// the modification time of a cache file tells when it was used
+	// last, it's only updated once in a while to save writes
+	if( cst.st_mtime < time( 0 )-Touch )
+		futimens( fd, 0 );
+
+	// the mapping stays valid after closing the file
+	close( fd );
+
+	size_t pixels = align( sizeof( Header )+h->pathlength );
+
+	return new Image( h->width, h->height, 
+		(int *) ((char *) map+pixels), map, cst.st_size );
+}
+
+/**
+ * Write image to cache, failures are silently ignored
+ *
+ * @param file - image file
+ * @param st - status of image file
+ * @param maxwidth - maximum width the image was scaled for
+ * @param maxheight - maximum height the image was scaled for
+ * @param scale - scale factor the image was scaled by
+ * @param image - decoded image
+ */
+void Cache::store( const string &file, const struct stat &st, 
+	int maxwidth, int maxheight, float scale, const Image &image )
+{
+	// a file that changes again within the resolution of its time
+	// stamps keeps them, so images of files that have just been
+	// written may not be cached or the cache entry may become stale
+	{
+		time_t now = time( 0 );
+
+		if( st.st_mtime >= now-1 ||
+			st.st_ctime >= now-1 )
+			return;
+	}
+
+	string path = getPath( file, maxwidth, maxheight, scale );
+
+	if( path.empty() )
+		return;
+
+	// remove unused entries once per process
+	{
+		bool prune = false;
+
+		pthread_mutex_lock( &mutex );
+
+		if( !pruned )
+			prune = pruned = true;
+
+		pthread_mutex_unlock( &mutex );
+
+		if( prune )
+			Cache::prune( getDirectory() );
+	}
+
+	Header h;
+
+	bzero( &h, sizeof( h ) );
+	memcpy( h.magic, Magic, sizeof( Magic ) );
+	h.width = image.getWidth();
+	h.height = image.getHeight();
+	h.maxwidth = maxwidth;
+	h.maxheight = maxheight;
+	h.scale = scale;
+	h.pathlength = file.length();
+	h.mtime = st.st_mtim.tv_sec;
+	h.mtimensec = st.st_mtim.tv_nsec;
+	h.ctime = st.st_ctim.tv_sec;
+	h.ctimensec = st.st_ctim.tv_nsec;
+	h.size = st.st_size;
+	h.inode = st.st_ino;
+
+	size_t offset = align( sizeof( Header )+h.pathlength );
+	size_t size = offset+(size_t) h.width*h.height*4;
+	char *buf;
+
+	if( !(buf = (char *) calloc( size, 1 )) )
+		return;
+
+	memcpy( buf, &h, sizeof( h ) );
+	memcpy( buf+sizeof( h ), file.c_str(), h.pathlength );
+	memcpy( buf+offset, image.getPixels(), size-offset );
+
+	// write to a temporary file and rename it to make the update
+	// atomic for other instances
+	char *tmp = (char *) malloc( path.length()+8 );
+	int fd;
+
+	if( !tmp )
+	{
+		free( buf );
+		return;
+	}
+
+	strcpy( tmp, path.c_str() );
+	strcat( tmp, ".XXXXXX" );
+
+	if( (fd = mkstemp( tmp )) > -1 )
+	{
+		size_t written = 0;
+
+		for( ssize_t n; written < size; written += n )
+			if( (n = write( fd, buf+written, size-written )) < 1 )
+				break;
+
+		close( fd );
+
+		if( written < size ||
+			rename( tmp, path.c_str() ) < 0 )
+			unlink( tmp );
+	}
+
+	free( tmp );
+	free( buf );
+}
+
+/**
+ * Return path of cache file for an image file, creates the cache
+ * directory if necessary
+ *
+ * @param file - image file
+ * @param maxwidth - maximum width of image
+ * @param maxheight - maximum height of image
+ * @param scale - scale factor
+ */
+string Cache::getPath( const string &file, int maxwidth, int maxheight, 
+	float scale )
+{
+	string dir = getDirectory();
+
+	if( dir.empty() )
+		return "";
+
+	// name cache files after a FNV-1a hash of the path, the size and
+	// the scale so different docks don't replace each other's entries
+	unsigned long long hash = 14695981039346656037ULL;
+	const char *p = file.c_str();
+
+	for( ; *p; p++ )
+	{
+		hash ^= (unsigned char) *p;
+		hash *= 1099511628211ULL;
+	}
+
+	char buf[64];
+
+	snprintf( buf, sizeof( buf ), "/%016llx-%dx%d-%d", hash, maxwidth, 
+		maxheight, (int) (scale*100+.5f) );
+
+	return dir+buf;
+}
+
+/**
+ * Return cache directory, creates it if necessary
+ */
+string Cache::getDirectory()
+{
+	string dir;
+	const char *env;
+
+	if( (env = getenv( "XDG_CACHE_HOME" )) && *env )
+		dir = env;
+	else if( (env = getenv( "HOME" )) && *env )
+	{
+		dir = env;
+		dir += "/.cache";
+	}
+	else
+		return "";
+
+	mkdir( dir.c_str(), 0700 );
+	dir += "/bbdock";
+
+	if( mkdir( dir.c_str(), 0700 ) < 0 &&
+		errno != EEXIST )
+		return "";
+
+	return dir;
+}
+
+/**
+ * Remove cache files that haven't been used for MaxAge seconds,
+ * including temporary files left over by interrupted writes
+ *
+ * @param dir - cache directory
+ */
+void Cache::prune( const string &dir )
+{
+	DIR *d;
+
+	if( dir.empty() ||
+		!(d = opendir( dir.c_str() )) )
+		return;
+
+	time_t limit = time( 0 )-MaxAge;
+
+	for( struct dirent *e; (e = readdir( d )); )
+	{
+		if( *e->d_name == '.' )
+			continue;
+
+		string path = dir+"/"+e->d_name;
+		struct stat st;
+
+		if( !lstat( path.c_str(), &st ) &&
+			S_ISREG( st.st_mode ) &&
+			st.st_mtime < limit )
+			unlink( path.c_str() );
+	}
+
+	closedir( d );
+}
+
+/**
+ * Round up to a multiple of the header size
+ *
+ * @param n - number of bytes
+ */
+size_t Cache::align( size_t n )
+{
+	return (n+sizeof( Header )-1)/sizeof( Header )*sizeof( Header );
+}
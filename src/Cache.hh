@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2006 Markus Fisch
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Markus Fisch nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef bbdock_Cache_hh
+#define bbdock_Cache_hh
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <string>
+
+#include "Image.hh"
+
+namespace bbdock
+{
+	/**
+	 * Cache keeps decoded images in $XDG_CACHE_HOME/bbdock in a
+	 * format that is memory-mapped as is, so warm starts don't need
+	 * to decode PNG files at all; entries are keyed by path,
+	 * modification and change time in nanoseconds, size and inode of
+	 * the image file and the size and scale factor the image has been
+	 * resampled for; entries that haven't been used for MaxAge
+	 * seconds are removed
+	 *
+	 * @author mf@markusfisch.de
+	 * @version 0.0.3
+	 */
+	class Cache
+	{
+		public:
+			static Image *load( const std::string &, int, int, 
+				float = 1, struct stat * = 0 );
+
+			enum
+			{
+				MaxAge = 2592000, // = 30 days
+				Touch = 86400 // = one day
+			};
+
+		private:
+			/**
+			 * Header of a cache file, followed by the path of the
+			 * image file and the pixels which both start at multiples
+			 * of the header size
+			 */
+			struct Header
+			{
+				char magic[8];
+				unsigned int width;
+				unsigned int height;
+				unsigned int maxwidth;
+				unsigned int maxheight;
+				unsigned int pathlength;
+				float scale;
+				long long mtime;
+				long long mtimensec;
+				long long ctime;
+				long long ctimensec;
+				long long size;
+				long long inode;
+			};
+
+			static const char Magic[8];
+			static pthread_mutex_t mutex;
+			static bool pruned;
+
+			static Image *find( const std::string &, const struct stat &, 
+				int, int, float );
+			static void store( const std::string &, const struct stat &, 
+				int, int, float, const Image & );
+			static std::string getPath( const std::string &, int, int, 
+				float );
+			static std::string getDirectory();
+			static void prune( const std::string & );
+			static size_t align( size_t );
+	};
+}
+
+#endif
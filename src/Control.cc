@@ -0,0 +1,482 @@
+/*
+ * Copyright (c) 2006 Markus Fisch
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Markus Fisch nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string>
+#include <vector>
+
+#include "Control.hh"
+#include "Dock.hh"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+using namespace std;
+using namespace bbdock;
+
+/**
+ * Create and bind the control socket
+ *
+ * @param d - Dock object
+ */
+Control::Control( Dock &d ) :
+	dock( &d ),
+	fd( -1 ),
+	path( getPath() )
+{
+	struct sockaddr_un addr;
+
+	if( path.length() >= sizeof( addr.sun_path ) )
+		throw "Control socket path is too long";
+
+	bzero( &addr, sizeof( addr ) );
+	addr.sun_family = AF_UNIX;
+	strcpy( addr.sun_path, path.c_str() );
+
+	if( (fd = socket( AF_UNIX, SOCK_STREAM, 0 )) < 0 )
+		throw "Can not create control socket";
+
+	// a left over socket of a previous instance is taken over just
+	// like the selection of the dock is
+	unlink( path.c_str() );
+
+	mode_t mask = umask( 077 );
+	int bound = bind( fd, (struct sockaddr *) &addr, sizeof( addr ) );
+	umask( mask );
+
+	if( bound < 0 ||
+		listen( fd, 8 ) < 0 ||
+		fcntl( fd, F_SETFL, O_NONBLOCK ) < 0 )
+	{
+		::close( fd );
+		throw "Can not bind control socket";
+	}
+
+	fcntl( fd, F_SETFD, FD_CLOEXEC );
+}
+
+/**
+ * Close all connections and remove socket
+ */
+Control::~Control()
+{
+	vector<Connection>::iterator it = connections.begin();
+	vector<Connection>::iterator end = connections.end();
+
+	for( ; it != end; ++it )
+		::close( it->getDescriptor() );
+
+	::close( fd );
+	unlink( path.c_str() );
+}
+
+/**
+ * Add descriptors to watch to the given sets, returns highest descriptor
+ *
+ * @param rfds - set of descriptors to watch for reading
+ * @param wfds - set of descriptors to watch for writing
+ */
+int Control::fill( fd_set &rfds, fd_set &wfds )
+{
+	int max = fd;
+
+	FD_SET( fd, &rfds );
+
+	vector<Connection>::iterator it = connections.begin();
+	vector<Connection>::iterator end = connections.end();
+
+	for( ; it != end; ++it )
+	{
+		int f = it->getDescriptor();
+
+		// stop reading requests while the client doesn't read replies
+		if( !it->isClosing() &&
+			it->getOutput().length() < MaxBacklog )
+			FD_SET( f, &rfds );
+
+		if( !it->getOutput().empty() )
+			FD_SET( f, &wfds );
+
+		if( f > max )
+			max = f;
+	}
+
+	return max;
+}
+
+/**
+ * Serve all descriptors that are ready
+ *
+ * @param rfds - set of descriptors ready for reading
+ * @param wfds - set of descriptors ready for writing
+ */
+void Control::process( fd_set &rfds, fd_set &wfds )
+{
+	for( vector<Connection>::iterator it = connections.begin();
+		it != connections.end(); )
+	{
+		int f = it->getDescriptor();
+		bool keep = true;
+
+		if( FD_ISSET( f, &rfds ) )
+			keep = receive( *it );
+
+		if( keep &&
+			!it->getOutput().empty() &&
+			(FD_ISSET( f, &wfds ) || FD_ISSET( f, &rfds )) )
+			keep = transmit( *it );
+
+		// subscribers that are done sending still want events, they
+		// are dropped when sending fails
+		if( keep &&
+			it->isClosing() &&
+			!it->isSubscribed() &&
+			it->getOutput().empty() )
+			keep = false;
+
+		if( keep )
+		{
+			++it;
+			continue;
+		}
+
+		::close( f );
+		it = connections.erase( it );
+	}
+
+	if( FD_ISSET( fd, &rfds ) )
+		accept();
+}
+
+/**
+ * Queue a line for all subscribed connections, events are dropped for
+ * subscribers that do not keep up
+ *
+ * @param line - line to send
+ */
+void Control::broadcast( const string &line )
+{
+	vector<Connection>::iterator it = connections.begin();
+	vector<Connection>::iterator end = connections.end();
+
+	for( ; it != end; ++it )
+		if( it->isSubscribed() &&
+			it->getOutput().length() < MaxBacklog )
+			it->getOutput() += line;
+}
+
+/**
+ * Returns true if there is at least one subscribed connection
+ */
+const bool Control::hasSubscribers() const
+{
+	vector<Connection>::const_iterator it = connections.begin();
+	vector<Connection>::const_iterator end = connections.end();
+
+	for( ; it != end; ++it )
+		if( it->isSubscribed() )
+			return true;
+
+	return false;
+}
+
+/**
+ * Return path of the control socket for the current display
+ */
+string Control::getPath()
+{
+	string p;
+	const char *dir;
+
+	if( !(dir = getenv( "XDG_RUNTIME_DIR" )) || !*dir )
+		dir = "/tmp";
+
+	char buf[32];
+
+	snprintf( buf, sizeof( buf ), "/bbdock-%d-", (int) getuid() );
+
+	p = dir;
+	p += buf;
+
+	const char *display;
+
+	if( !(display = getenv( "DISPLAY" )) )
+		display = "";
+
+	for( ; *display; display++ )
+		p += (*display == '/' ? '_' : *display);
+
+	return p;
+}
+
+/**
+ * Pass commands from in to a running dock and write replies to out,
+ * returns 0 on success
+ *
+ * @param in - stream to read commands from
+ * @param out - stream to write replies to
+ */
+int Control::send( FILE *in, FILE *out )
+{
+	struct sockaddr_un addr;
+	string p = getPath();
+	int s;
+
+	if( p.length() >= sizeof( addr.sun_path ) )
+		return -1;
+
+	bzero( &addr, sizeof( addr ) );
+	addr.sun_family = AF_UNIX;
+	strcpy( addr.sun_path, p.c_str() );
+
+	if( (s = socket( AF_UNIX, SOCK_STREAM, 0 )) < 0 )
+		return -1;
+
+	if( connect( s, (struct sockaddr *) &addr, sizeof( addr ) ) < 0 )
+	{
+		::close( s );
+		return -1;
+	}
+
+	int infd = fileno( in );
+	char buf[4096];
+
+	for( bool reading = true; ; )
+	{
+		fd_set rfds;
+
+		FD_ZERO( &rfds );
+		FD_SET( s, &rfds );
+
+		if( reading )
+			FD_SET( infd, &rfds );
+
+		if( select( (s > infd ? s : infd)+1, &rfds, 0, 0, 0 ) < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+
+			break;
+		}
+
+		if( reading &&
+			FD_ISSET( infd, &rfds ) )
+		{
+			ssize_t n = read( infd, buf, sizeof( buf ) );
+
+			if( n > 0 )
+			{
+				for( ssize_t sent = 0, w; sent < n; sent += w )
+					if( (w = ::send( s, buf+sent, n-sent, 
+						MSG_NOSIGNAL )) < 0 )
+						break;
+			}
+			else
+			{
+				// no more commands, wait for the remaining replies
+				shutdown( s, SHUT_WR );
+				reading = false;
+			}
+		}
+
+		if( FD_ISSET( s, &rfds ) )
+		{
+			ssize_t n = recv( s, buf, sizeof( buf ), 0 );
+
+			if( n <= 0 )
+				break;
+
+			fwrite( buf, 1, n, out );
+			fflush( out );
+		}
+	}
+
+	::close( s );
+
+	return 0;
+}
+
+/**
+ * Accept pending connections, connections beyond MaxConnections or
+ * descriptors that don't fit into a fd_set are refused
+ */
+void Control::accept()
+{
+	for( int f; (f = ::accept( fd, 0, 0 )) > -1; )
+	{
+		if( connections.size() >= MaxConnections ||
+			f >= FD_SETSIZE )
+		{
+			::close( f );
+			continue;
+		}
+
+		fcntl( f, F_SETFL, O_NONBLOCK );
+		fcntl( f, F_SETFD, FD_CLOEXEC );
+
+		connections.push_back( Connection( f ) );
+	}
+}
+
+/**
+ * Read from a connection and dispatch all complete lines, returns
+ * false if the connection should be dropped
+ *
+ * @param c - connection
+ */
+bool Control::receive( Connection &c )
+{
+	char buf[4096];
+	ssize_t n;
+
+	if( (n = recv( c.getDescriptor(), buf, sizeof( buf ), 0 )) < 0 )
+		return (errno == EAGAIN || errno == EINTR);
+
+	if( !n )
+	{
+		// client is done sending, close when all replies are out
+		// unless it is subscribed
+		c.close();
+		return true;
+	}
+
+	string &input = c.getInput();
+	string::size_type p;
+
+	input.append( buf, n );
+
+	while( (p = input.find( '\n' )) != string::npos )
+	{
+		string line = input.substr( 0, p );
+
+		input.erase( 0, p+1 );
+		dispatch( c, line );
+	}
+
+	return input.length() < MaxLine;
+}
+
+/**
+ * Write as much pending output as possible, returns false if the
+ * connection should be dropped
+ *
+ * @param c - connection
+ */
+bool Control::transmit( Connection &c )
+{
+	string &output = c.getOutput();
+	ssize_t n;
+
+	if( (n = ::send( c.getDescriptor(), output.data(), output.length(), 
+		MSG_NOSIGNAL )) < 0 )
+		return (errno == EAGAIN || errno == EINTR);
+
+	output.erase( 0, n );
+
+	return true;
+}
+
+/**
+ * Execute one command line and queue its reply
+ *
+ * @param c - connection
+ * @param line - command line
+ */
+void Control::dispatch( Connection &c, string line )
+{
+	string::size_type p;
+
+	if( (p = line.find_last_not_of( "\r" )) != string::npos )
+		line.erase( p+1 );
+	else
+		line.clear();
+
+	string verb;
+	string arg;
+
+	if( (p = line.find( ' ' )) != string::npos )
+	{
+		verb = line.substr( 0, p );
+		arg = line.substr( p+1 );
+	}
+	else
+		verb = line;
+
+	string &output = c.getOutput();
+
+	if( verb.empty() )
+		return;
+	else if( verb == "icon" )
+	{
+		if( (p = arg.find( ':' )) == string::npos ||
+			!p ||
+			p+1 >= arg.length() )
+			output += "error invalid argument\n";
+		else if( !dock->setIcon( arg.substr( 0, p ).c_str(),
+			arg.substr( p+1 ).c_str() ) )
+			output += "error no such command\n";
+		else
+			output += "ok\n";
+	}
+	else if( verb == "exec" )
+	{
+		if( arg.empty() )
+			output += "error invalid argument\n";
+		else if( !dock->execute( arg.c_str() ) )
+			output += "error no such command\n";
+		else
+			output += "ok\n";
+	}
+	else if( verb == "subscribe" )
+	{
+		c.subscribe();
+		output += "ok\n";
+	}
+	else if( verb == "state" )
+	{
+		dock->getState( output );
+		output += "ok\n";
+	}
+	else if( verb == "stats" )
+	{
+		dock->getStats( output );
+		output += "ok\n";
+	}
+	else
+		output += "error unknown command\n";
+}
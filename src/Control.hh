@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2006 Markus Fisch
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Markus Fisch nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef bbdock_Control_hh
+#define bbdock_Control_hh
+
+#include <sys/types.h>
+#include <sys/select.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace bbdock
+{
+	// forward declaration
+	class Dock;
+
+	/**
+	 * Control serves a local socket that takes line based commands
+	 * for a Dock; a client may send any number of commands over one
+	 * connection and gets the replies in order, each one terminated
+	 * by a line that is either "ok" or "error" followed by a reason;
+	 * subscribed connections additionally receive event lines
+	 *
+	 * @author mf@markusfisch.de
+	 * @version 0.0.2
+	 */
+	class Control
+	{
+		public:
+			Control( Dock & );
+			virtual ~Control();
+			virtual int fill( fd_set &, fd_set & );
+			virtual void process( fd_set &, fd_set & );
+			virtual void broadcast( const std::string & );
+			virtual const bool hasSubscribers() const;
+			static std::string getPath();
+			static int send( FILE *, FILE * );
+
+			enum
+			{
+				MaxLine = 65536,
+				MaxBacklog = 1048576,
+				MaxConnections = 64
+			};
+
+		private:
+			/**
+			 * A client connection
+			 */
+			class Connection
+			{
+				public:
+					inline const int &getDescriptor() const { return fd; }
+					inline std::string &getInput() { return input; }
+					inline std::string &getOutput() { return output; }
+					inline const bool &isClosing() const { return closing; }
+					inline const void close() { closing = true; }
+					inline const bool &isSubscribed() const { 
+						return subscribed; }
+					inline const void subscribe() { subscribed = true; }
+
+					Connection( int f ) :
+						fd( f ),
+						closing( false ),
+						subscribed( false ) {}
+					virtual ~Connection() {}
+
+				private:
+					int fd;
+					std::string input;
+					std::string output;
+					bool closing;
+					bool subscribed;
+			};
+
+			Dock *dock;
+			int fd;
+			std::string path;
+			std::vector<Connection> connections;
+
+			void accept();
+			bool receive( Connection & );
+			bool transmit( Connection & );
+			void dispatch( Connection &, std::string );
+	};
+}
+
+#endif
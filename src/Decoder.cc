@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2006 Markus Fisch
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Markus Fisch nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <sys/types.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include "Cache.hh"
+#include "Decoder.hh"
+
+using namespace std;
+using namespace bbdock;
+
+/**
+ * Start worker threads
+ *
+ * @param w - maximum width of images
+ * @param h - maximum height of images
+ * @param s - scale factor of images (optional)
+ * @param workers - number of threads, 0 for one per processor (optional)
+ */
+Decoder::Decoder( int w, int h, float s, int workers ) :
+	maxwidth( w ),
+	maxheight( h ),
+	scale( s ),
+	quit( false )
+{
+	if( pipe( fds ) < 0 )
+		throw "Can not create pipe";
+
+	for( int n = 2; n--; )
+	{
+		fcntl( fds[n], F_SETFL, O_NONBLOCK );
+		fcntl( fds[n], F_SETFD, FD_CLOEXEC );
+	}
+
+	if( workers < 1 &&
+		(workers = sysconf( _SC_NPROCESSORS_ONLN )) < 1 )
+		workers = 1;
+
+	if( workers > MaxWorkers )
+		workers = MaxWorkers;
+
+	pthread_mutex_init( &mutex, 0 );
+	pthread_cond_init( &cond, 0 );
+
+	for( ; workers--; )
+	{
+		pthread_t thread;
+
+		if( !pthread_create( &thread, 0, Decoder::work, this ) )
+			threads.push_back( thread );
+	}
+
+	if( threads.empty() )
+		throw "Can not start decoder threads";
+}
+
+/**
+ * Stop workers and drop all jobs
+ */
+Decoder::~Decoder()
+{
+	pthread_mutex_lock( &mutex );
+	quit = true;
+	pthread_cond_broadcast( &cond );
+	pthread_mutex_unlock( &mutex );
+
+	vector<pthread_t>::iterator it = threads.begin();
+	vector<pthread_t>::iterator end = threads.end();
+
+	for( ; it != end; ++it )
+		pthread_join( *it, 0 );
+
+	for( ; !done.empty(); done.pop_front() )
+		if( done.front().getImage() )
+			done.front().getImage()->release();
+
+	pthread_cond_destroy( &cond );
+	pthread_mutex_destroy( &mutex );
+
+	close( fds[0] );
+	close( fds[1] );
+}
+
+/**
+ * Queue a file for decoding unless it is waiting or being decoded
+ * already; a changed file that is being decoded right now is queued
+ * again since the running decode may have read the old contents
+ *
+ * @param file - image file
+ * @param changed - true if the file has changed (optional)
+ */
+void Decoder::decode( const string &file, bool changed )
+{
+	pthread_mutex_lock( &mutex );
+
+	deque<Job>::iterator it = pending.begin();
+	deque<Job>::iterator end = pending.end();
+
+	for( ; it != end; ++it )
+		if( it->getFile() == file )
+			break;
+
+	if( it == end &&
+		(changed ||
+			find( running.begin(), running.end(), file ) == 
+				running.end()) )
+	{
+		pending.push_back( Job( file ) );
+		pthread_cond_signal( &cond );
+	}
+
+	pthread_mutex_unlock( &mutex );
+}
+
+/**
+ * Take a finished job, returns false if there is none; the image of
+ * the job is owned by the caller then
+ *
+ * @param job - receives the job
+ */
+bool Decoder::fetch( Job &job )
+{
+	// drain notifications, fetch() is called until it returns false
+	{
+		char buf[64];
+
+		while( read( fds[0], buf, sizeof( buf ) ) > 0 );
+	}
+
+	pthread_mutex_lock( &mutex );
+
+	bool available = !done.empty();
+
+	if( available )
+	{
+		job = done.front();
+		done.pop_front();
+	}
+
+	pthread_mutex_unlock( &mutex );
+
+	return available;
+}
+
+/**
+ * Worker thread
+ *
+ * @param d - Decoder object
+ */
+void *Decoder::work( void *d )
+{
+	Decoder *decoder = (Decoder *) d;
+
+	for( ;; )
+	{
+		pthread_mutex_lock( &decoder->mutex );
+
+		while( !decoder->quit &&
+			decoder->pending.empty() )
+			pthread_cond_wait( &decoder->cond, &decoder->mutex );
+
+		if( decoder->quit )
+		{
+			pthread_mutex_unlock( &decoder->mutex );
+			break;
+		}
+
+		Job job = decoder->pending.front();
+		decoder->pending.pop_front();
+		decoder->running.push_back( job.getFile() );
+
+		pthread_mutex_unlock( &decoder->mutex );
+
+		try
+		{
+			struct stat st;
+
+			job.setImage( Cache::load( job.getFile(), 
+				decoder->maxwidth, decoder->maxheight, decoder->scale,
+				&st ) );
+			job.setStatus( st );
+		}
+		catch( const char *e )
+		{
+			job.setError( e );
+		}
+		catch( ... )
+		{
+			job.setError( "Unknown error" );
+		}
+
+		pthread_mutex_lock( &decoder->mutex );
+		decoder->done.push_back( job );
+		decoder->running.erase( find( decoder->running.begin(), 
+			decoder->running.end(), job.getFile() ) );
+		pthread_mutex_unlock( &decoder->mutex );
+
+		// wake up the main thread
+		char c = 0;
+
+		write( decoder->fds[1], &c, 1 );
+	}
+
+	return 0;
+}
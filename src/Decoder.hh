@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2006 Markus Fisch
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Markus Fisch nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef bbdock_Decoder_hh
+#define bbdock_Decoder_hh
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <string.h>
+#include <string>
+#include <deque>
+#include <vector>
+
+#include "Image.hh"
+
+namespace bbdock
+{
+	/**
+	 * Decoder loads images on a small pool of worker threads; finished
+	 * jobs are signalled through a descriptor that can be select()ed
+	 * and get picked up on the main thread; images are scaled by a
+	 * factor and to fit into a given size and come with the status
+	 * of the file they were decoded from; a file that is already
+	 * waiting or being decoded is not queued again
+	 *
+	 * @author mf@markusfisch.de
+	 * @version 0.0.4
+	 */
+	class Decoder
+	{
+		public:
+			/**
+			 * A decode job
+			 */
+			class Job
+			{
+				public:
+					inline const std::string &getFile() const { 
+						return file; }
+					inline Image *getImage() const { return image; }
+					inline const char *getError() const { return error; }
+					inline const struct stat &getStatus() const { 
+						return status; }
+					inline const void setImage( Image *i ) { image = i; }
+					inline const void setError( const char *e ) { 
+						error = e; }
+					inline const void setStatus( const struct stat &s ) { 
+						status = s; }
+
+					Job() :
+						image( 0 ),
+						error( 0 ) { memset( &status, 0, sizeof( status ) ); }
+					Job( const std::string &f ) :
+						file( f ),
+						image( 0 ),
+						error( 0 ) { memset( &status, 0, sizeof( status ) ); }
+					virtual ~Job() {}
+
+				private:
+					std::string file;
+					Image *image;
+					const char *error;
+					struct stat status;
+			};
+
+			inline const int &getDescriptor() const { return fds[0]; }
+
+			enum
+			{
+				MaxWorkers = 4
+			};
+
+			Decoder( int, int, float = 1, int = 0 );
+			virtual ~Decoder();
+			virtual void decode( const std::string &, bool = false );
+			virtual bool fetch( Job & );
+
+		private:
+			pthread_mutex_t mutex;
+			pthread_cond_t cond;
+			std::vector<pthread_t> threads;
+			std::deque<Job> pending;
+			std::deque<Job> done;
+			std::vector<std::string> running;
+			int fds[2];
+			int maxwidth;
+			int maxheight;
+			float scale;
+			bool quit;
+
+			static void *work( void * );
+	};
+}
+
+#endif
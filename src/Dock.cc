@@ -28,14 +28,30 @@
  */
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/wait.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <strings.h>
 #include <unistd.h>
+#include <ctype.h>
+#include <fcntl.h>
 #include <iostream>
+#include <fstream>
+#include <algorithm>
 #include <string>
+#include <vector>
+#include <map>
 
+#include "Control.hh"
+#include "Decoder.hh"
 #include "Dock.hh"
+#include "Histogram.hh"
+#include "Property.hh"
+#include "Repository.hh"
 #include "Slot.hh"
+#include "Watcher.hh"
 #include "WindowManager.hh"
 
 using namespace std;
@@ -43,6 +59,8 @@ using namespace bbdock;
 
 const char *Dock::ChangeIconMessage = "_BBDOCK_CHANGE_ICON_";
 const char *Dock::ExecuteIconMessage = "_BBDOCK_EXECUTE_ICON_";
+const char *Dock::SelectionPrefix = "_BBDOCK_S";
+int Dock::signals[2] = { -1, -1 };
 
 /**
  * Initialize dock
@@ -51,7 +69,16 @@ const char *Dock::ExecuteIconMessage = "_BBDOCK_EXECUTE_ICON_";
  */
 Dock::Dock( Dock::Settings &s ) :
 	settings( s ),
-	first( 0 )
+	control( 0 ),
+	decoder( 0 ),
+	watcher( 0 ),
+	focused( 0 ),
+	invalidated( false ),
+	wallpaper( 0 ),
+	wallpaperwidth( 0 ),
+	wallpaperheight( 0 ),
+	wallpaperchecked( false ),
+	started( false )
 {
 	if(	!(display = XOpenDisplay( 0 )) )
 		throw "Unable to open display";
@@ -62,6 +89,27 @@ Dock::Dock( Dock::Settings &s ) :
 
 	gc = XDefaultGC( display, screen );
 
+	// scale dimensions for high resolution screens, icons get
+	// resampled once when they are loaded
+	if( settings.getScale() <= 0 )
+		settings.setScale( getScaleFactor( display ) );
+
+	if( getScale() != 1 )
+	{
+		float s = getScale();
+
+		settings.setSlotWidth( (int) (getSlotWidth()*s+.5f) );
+		settings.setSlotHeight( (int) (getSlotHeight()*s+.5f) );
+		settings.setMarkLeft( (int) (getMarkLeft()*s) );
+		settings.setMarkTop( (int) (getMarkTop()*s) );
+	}
+
+	decoder = new Decoder( getSlotWidth(), getSlotHeight(), getScale() );
+	watcher = new Watcher();
+	activewindow = XInternAtom( display, "_NET_ACTIVE_WINDOW", False );
+	clientlist = XInternAtom( display, "_NET_CLIENT_LIST", False );
+	rootpixmap = XInternAtom( display, "_XROOTPMAP_ID", False );
+
 	// determine bits per pixel of an screen-compatible XImage, does not 
 	// need to be the same as the color-depth of the screen
 	{
@@ -86,6 +134,54 @@ Dock::Dock( Dock::Settings &s ) :
 			XFree( (char *) pf );
 		}
 	}
+
+	visual = DefaultVisual( display, screen );
+	depth = DefaultDepth( display, screen );
+	colormap = DefaultColormap( display, screen );
+	alpha = false;
+
+	// let a running compositor blend the slots with what is behind
+	// them so backgrounds don't need to be captured; this is opt-in
+	// because the server blends a 32 bit child into a slit of another
+	// depth without its alpha channel
+	if( settings.getCompositing() )
+	{
+		char name[32];
+		XVisualInfo vi;
+
+		snprintf( name, sizeof( name ), "_NET_WM_CM_S%d", screen );
+
+		if( XGetSelectionOwner( display, 
+				XInternAtom( display, name, False ) ) != None &&
+			XMatchVisualInfo( display, screen, 32, TrueColor, &vi ) )
+		{
+			visual = vi.visual;
+			depth = vi.depth;
+			colormap = XCreateColormap( display, 
+				RootWindow( display, screen ), visual, AllocNone );
+			bitsperpixel = 32;
+			alpha = true;
+		}
+	}
+
+	// create a window to receive remote messages and announce it by
+	// owning a selection so remote calls find it in one request
+	{
+		window = XCreateSimpleWindow( display, 
+			RootWindow( display, screen ), 0, 0, 1, 1, 0, 0, 0 );
+
+		XClassHint xch;
+
+		xch.res_name = (char *) "bbdock";
+		xch.res_class = xch.res_name;
+
+		XSetClassHint( display, window, &xch );
+
+		XSetSelectionOwner( display, 
+			XInternAtom( display, getSelectionName( screen ).c_str(), 
+				False ),
+			window, CurrentTime );
+	}
 }
 
 /**
@@ -93,6 +189,14 @@ Dock::Dock( Dock::Settings &s ) :
  */
 Dock::~Dock()
 {
+	delete control;
+	delete decoder;
+	delete watcher;
+
+	if( alpha )
+		XFreeColormap( display, colormap );
+
+	XDestroyWindow( display, window );
 	XCloseDisplay( display );
 }
 
@@ -106,40 +210,363 @@ bool Dock::add( Icon *icon )
 	if( !icon )
 		return false;
 
-	first = new Slot( *this, *icon, first );
+	Slot *slot = new Slot( *this, *icon, slots.size() );
+
+	slots.push_back( slot );
+	windows.push_back( slot->getWindow() );
+
+	assign( slot );
+
+	// commands are matched case-insensitive
+	commands[fold( slot->getCommand() )] = slot;
+
+	return true;
+}
+
+/**
+ * Load icons from a configuration file, if there are already slots
+ * only the differences get applied; returns false if the file can't
+ * be read
+ *
+ * @param file - path and filename of configuration file
+ */
+bool Dock::load( const string &file )
+{
+	ifstream fin( file.c_str(), ios::in );
+
+	if( !fin )
+		return false;
+
+	vector<Icon *> icons;
+
+	for( string buf; getline( fin, buf ); )
+	{
+		Icon *icon;
+
+		if( (icon = Icon::parse( (char *) buf.c_str(), ':' )) )
+			icons.push_back( icon );
+	}
+
+	rcfile = file;
+	watcher->watch( rcfile );
+
+	configure( icons );
 
 	return true;
 }
 
+/**
+ * Make the slots match a list of icons; slots are matched by command
+ * and kept with their windows, images and running instances, only
+ * slots that are gone get destroyed and only new ones get created;
+ * afterwards the slots are in the order of the list
+ *
+ * @param icons - list of Icon objects, ownership is taken
+ */
+void Dock::configure( vector<Icon *> &icons )
+{
+	multimap<string, Slot *> unused;
+
+	{
+		vector<Slot *>::iterator it = slots.begin();
+		vector<Slot *>::iterator end = slots.end();
+
+		for( ; it != end; ++it )
+			unused.insert( pair<string, Slot *>( 
+				fold( (*it)->getCommand() ), *it ) );
+	}
+
+	vector<Icon *> added;
+
+	// slots in order of the list, 0 where a slot gets added
+	vector<Slot *> order;
+
+	{
+		vector<Icon *>::iterator it = icons.begin();
+		vector<Icon *>::iterator end = icons.end();
+
+		for( ; it != end; ++it )
+		{
+			multimap<string, Slot *>::iterator u;
+
+			if( (u = unused.find( fold( 
+				(*it)->getCommand().c_str() ) )) == unused.end() )
+			{
+				added.push_back( *it );
+				order.push_back( 0 );
+				continue;
+			}
+
+			Slot *slot = u->second;
+			string image = slot->getIcon();
+
+			unused.erase( u );
+			slot->replace( *it );
+			order.push_back( slot );
+
+			if( image != slot->getIcon() )
+				assign( slot );
+		}
+	}
+
+	{
+		multimap<string, Slot *>::iterator it = unused.begin();
+		multimap<string, Slot *>::iterator end = unused.end();
+
+		for( ; it != end; ++it )
+			remove( it->second );
+	}
+
+	int first = slots.size();
+
+	{
+		vector<Icon *>::iterator it = added.begin();
+		vector<Icon *>::iterator end = added.end();
+
+		for( ; it != end; ++it )
+			add( *it );
+	}
+
+	// move kept slots to their new places, new slots have been
+	// appended in order of the list
+	{
+		int size = order.size();
+
+		for( int n = 0; n < size; ++n )
+			if( !order[n] )
+				order[n] = slots[first++];
+
+		slots.swap( order );
+
+		windows.clear();
+
+		for( int n = 0; n < size; ++n )
+			windows.push_back( slots[n]->getWindow() );
+	}
+
+	renumber();
+}
+
+/**
+ * Number slots in order of addition and index them by command
+ */
+void Dock::renumber()
+{
+	int id = 0;
+
+	commands.clear();
+
+	vector<Slot *>::iterator it = slots.begin();
+	vector<Slot *>::iterator end = slots.end();
+
+	for( ; it != end; ++it, ++id )
+	{
+		(*it)->setId( id );
+		commands[fold( (*it)->getCommand() )] = *it;
+	}
+}
+
+/**
+ * Destroy a slot
+ *
+ * @param slot - Slot object
+ */
+void Dock::remove( Slot *slot )
+{
+	for( int n = slots.size(); n--; )
+		if( slots[n] == slot )
+		{
+			slots.erase( slots.begin()+n );
+			windows.erase( windows.begin()+n );
+			break;
+		}
+
+	if( focused == slot )
+		focused = 0;
+
+	// instances keep running but must still be reaped
+	if( slot->getPid() )
+		orphans.push_back( slot->getPid() );
+
+	delete slot;
+}
+
+/**
+ * Show the image of a slot; images already known are shared, all
+ * others get decoded in the background and are shown when ready
+ *
+ * @param slot - Slot object
+ */
+void Dock::assign( Slot *slot )
+{
+	Image *image;
+
+	if( (image = Repository::get( slot->getIcon(), getSlotWidth(), 
+		getSlotHeight(), getScale() )) )
+		slot->setImage( image );
+	else
+		decoder->decode( slot->getIcon() );
+
+	watcher->watch( slot->getIcon() );
+}
+
+/**
+ * Signal handler to reload the configuration
+ */
+void Dock::hangup( int )
+{
+	char c = 0;
+
+	write( signals[1], &c, 1 );
+}
+
 /**
  * Run the dock
  */
 void Dock::run()
 {
-	if( !first )
+	if( slots.empty() )
 		return;
 
+	// the control socket is optional, the dock works without it
+	try
+	{
+		control = new Control( *this );
+	}
+	catch( const char *e )
+	{
+		cerr << e << endl;
+	}
+
+	// reload configuration on SIGHUP
+	if( !rcfile.empty() &&
+		signals[0] < 0 &&
+		!pipe( signals ) )
+	{
+		for( int n = 2; n--; )
+		{
+			fcntl( signals[n], F_SETFL, O_NONBLOCK );
+			fcntl( signals[n], F_SETFD, FD_CLOEXEC );
+		}
+
+		struct sigaction sa;
+
+		bzero( &sa, sizeof( sa ) );
+		sa.sa_handler = Dock::hangup;
+		sigemptyset( &sa.sa_mask );
+		sigaction( SIGHUP, &sa, 0 );
+	}
+
+	// watch the active window and the client list to tell subscribers
+	// about focus changes and to measure launches
+	XSelectInput( display, RootWindow( display, screen ), 
+		PropertyChangeMask );
+
+	// ticks are scheduled on the monotonic clock so steps of the
+	// wall clock don't stop them
+	long long next = Histogram::now();
+
 	for( int xfd = ConnectionNumber( display ); ; )
 	{
+		// capture backgrounds when all pending events are handled so
+		// a reconfiguration of the slit is done in one go
+		if( invalidated &&
+			!XPending( display ) )
+			refresh();
+
 		if( !XPending( display ) )
 		{
-			Slot *slot;
+			struct timeval tv;
+
+			// tick in fixed intervals no matter how often select()
+			// returns early
+			long long now = Histogram::now();
+
+			if( now >= next )
+			{
+				for( int n = 0, size = slots.size(); n < size; ++n )
+					slots[n]->tick();
+
+				for( vector<pid_t>::iterator it = orphans.begin();
+					it != orphans.end(); )
+					if( waitpid( *it, 0, WNOHANG ) == *it )
+						it = orphans.erase( it );
+					else
+						++it;
+
+				next = now+Suspend;
+
+				// ticking may have queued requests or invalidated
+				// backgrounds
+				if( invalidated ||
+					XPending( display ) )
+					continue;
+			}
 
-			for( slot = first;
-				slot;
-				slot = slot->getNext() )
-				slot->tick();
+			tv.tv_sec = (next-now)/1000000;
+			tv.tv_usec = (next-now)%1000000;
 
 			fd_set rfds;
-			struct timeval tv;
+			fd_set wfds;
+			int dfd = decoder->getDescriptor();
+			int wfd = watcher->getDescriptor();
+			int maxfd = (xfd > dfd ? xfd : dfd);
 
 			FD_ZERO( &rfds );
+			FD_ZERO( &wfds );
 			FD_SET( xfd, &rfds );
+			FD_SET( dfd, &rfds );
+
+			if( wfd > -1 )
+			{
+				FD_SET( wfd, &rfds );
+
+				if( wfd > maxfd )
+					maxfd = wfd;
+			}
+
+			if( signals[0] > -1 )
+			{
+				FD_SET( signals[0], &rfds );
+
+				if( signals[0] > maxfd )
+					maxfd = signals[0];
+			}
+
+			if( control )
+			{
+				int fd = control->fill( rfds, wfds );
+
+				if( fd > maxfd )
+					maxfd = fd;
+			}
+
+			if( select( maxfd+1, &rfds, &wfds, 0, &tv ) > 0 )
+			{
+				if( FD_ISSET( dfd, &rfds ) )
+					update();
+
+				if( wfd > -1 &&
+					FD_ISSET( wfd, &rfds ) )
+					reload();
+
+				if( signals[0] > -1 &&
+					FD_ISSET( signals[0], &rfds ) )
+				{
+					char buf[16];
+
+					while( read( signals[0], buf, sizeof( buf ) ) > 0 );
+
+					started = true;
+
+					if( !load( rcfile ) )
+						cerr << "Unable to read " << rcfile << endl;
+				}
 
-			tv.tv_sec = 0;
-			tv.tv_usec = Suspend;
+				if( control )
+					control->process( rfds, wfds );
+			}
 
-			select( xfd+1, &rfds, 0, 0, &tv );
 			continue;
 		}
 
@@ -150,16 +577,37 @@ void Dock::run()
 
 		Slot *slot;
 
-		for( slot = first;
-			slot;
-			slot = slot->getNext() )
-			if( event.xany.window == slot->getWindow() )
-				break;
-
-		if( !slot )
+		if( !(slot = getSlot( event.xany.window )) )
 		{
 			if( event.type == ClientMessage )
 				client( &event );
+			else if( event.type == PropertyNotify &&
+				(event.xproperty.atom == activewindow ||
+					event.xproperty.atom == clientlist) )
+			{
+				Window active = WindowManager( display ).getActiveWindow();
+
+				// measure how long launched applications take to
+				// show up
+				for( int n = 0, size = slots.size(); n < size; ++n )
+					slots[n]->track( active );
+
+				if( event.xproperty.atom == activewindow &&
+					isObserved() )
+					updateFocus( active );
+			}
+			else if( event.type == PropertyNotify &&
+				event.xproperty.atom == rootpixmap )
+			{
+				// backgrounds taken from the old wallpaper are stale
+				wallpaperchecked = false;
+
+				for( int n = 0, size = slots.size(); n < size; ++n )
+				{
+					slots[n]->invalidate();
+					slots[n]->draw( true );
+				}
+			}
 
 			continue;
 		}
@@ -167,14 +615,40 @@ void Dock::run()
 		switch( event.type )
 		{
 			case Expose:
+				slot->damage( event.xexpose.x-slot->getLeft(),
+					event.xexpose.y-slot->getTop(),
+					event.xexpose.width, event.xexpose.height );
+
 				if( !event.xexpose.count )
-					slot->draw();
+					slot->repair();
 				break;
 			case VisibilityNotify:
+				// replace a background that may have been taken from
+				// the wallpaper with what is really there
+				if( event.xvisibility.state == VisibilityUnobscured &&
+					slot->getVisibility() != VisibilityUnobscured )
+				{
+					slot->setVisibility( event.xvisibility.state );
+					slot->invalidate();
+					slot->draw( true );
+					break;
+				}
+
 				slot->setVisibility( event.xvisibility.state );
 				break;
+			case ReparentNotify:
+				slot->setGeometry( event.xreparent.parent, 
+					event.xreparent.x, event.xreparent.y );
+				slot->draw( true );
+				break;
 			case ConfigureNotify:
-				slot->invalidate();
+				// synthetic events come with root coordinates
+				if( event.xconfigure.send_event )
+					slot->invalidate();
+				else
+					slot->setGeometry( slot->getParent(), 
+						event.xconfigure.x, event.xconfigure.y );
+
 				slot->draw( true );
 				break;
 			case SelectionNotify:
@@ -208,6 +682,8 @@ void Dock::run()
 				{
 					case 1:
 						{
+							long long clicked = Histogram::now();
+
 							if( getMarkType() == Render::CrossMark )
 							{
 								int l = getMarkLeft();
@@ -249,7 +725,7 @@ void Dock::run()
 								}
 							}
 
-							slot->exec();
+							slot->exec( 0, clicked );
 						}
 						break;
 					case 2:
@@ -291,6 +767,8 @@ void Dock::run()
  * Send a message to a running instance of bbdock
  *
  * @param message - the message to send
+ * @param data - message data
+ * @param len - length of data in bytes
  */
 void Dock::send( const char *message, const char *data, int len )
 {
@@ -300,13 +778,72 @@ void Dock::send( const char *message, const char *data, int len )
 
 	Display *display;
 	int screen;
-	Window root;
 
 	if(	!(display = XOpenDisplay( 0 )) )
 		throw "Unable to open display";
 
 	screen = DefaultScreen( display );
 
+	Atom msg;
+	Window target;
+
+	if( (target = find( display, screen, message, msg )) )
+	{
+		XChangeProperty( display, target, msg, msg, 8, 
+			PropModeReplace, (unsigned char *) data, len );
+	
+		XEvent event;
+
+		event.xclient.type = ClientMessage;
+		event.xclient.serial = 0;
+		event.xclient.send_event = True;
+		event.xclient.message_type = msg;
+		event.xclient.window = target;
+		event.xclient.format = 32;
+		event.xclient.data.l[0] = 0;
+		event.xclient.data.l[1] = 0;
+		event.xclient.data.l[2] = 0;
+		event.xclient.data.l[3] = 0;
+		event.xclient.data.l[4] = 0;
+
+		XSendEvent( display, target, True, NoEventMask, &event );
+	}
+
+	XCloseDisplay( display );
+}
+
+/**
+ * Find the window of a running instance of bbdock; a running dock
+ * owns a selection for its screen so this takes just one round trip,
+ * windows of older instances are searched for the hard way
+ *
+ * @param display - display
+ * @param screen - screen number
+ * @param message - name of the message atom to intern along
+ * @param msg - receives the message atom
+ */
+Window Dock::find( Display *display, int screen, const char *message,
+	Atom &msg )
+{
+	string selection = getSelectionName( screen );
+	char *names[2];
+	Atom atoms[2];
+
+	names[0] = (char *) message;
+	names[1] = (char *) selection.c_str();
+
+	if( !XInternAtoms( display, names, 2, False, atoms ) )
+		return 0;
+
+	msg = atoms[0];
+
+	Window target;
+
+	if( (target = XGetSelectionOwner( display, atoms[1] )) != None )
+		return target;
+
+	Window root;
+
 	if( !(root = RootWindow( display, screen )) )
 		throw "Can not access root window";
 
@@ -316,9 +853,7 @@ void Dock::send( const char *message, const char *data, int len )
 
  	XQueryTree( display, root, &dummy, &dummy, &childs, &n );
 
-	Atom msg = XInternAtom( display, message, false );
-
-	for( ; n--; )
+	for( target = 0; n--; )
 	{
 		XClassHint xch;
 
@@ -328,24 +863,7 @@ void Dock::send( const char *message, const char *data, int len )
 		if( !strcmp( xch.res_name, "bbdock" ) &&
 			!strcmp( xch.res_class, "bbdock" ) )
 		{
-			XChangeProperty( display, childs[n], msg, msg, 8, 
-				PropModeReplace, (unsigned char *) data, len );
-		
-			XEvent event;
-
-			event.xclient.type = ClientMessage;
-			event.xclient.serial = 0;
-			event.xclient.send_event = True;
-			event.xclient.message_type = msg;
-			event.xclient.window = childs[n];
-			event.xclient.format = 32;
-			event.xclient.data.l[0] = 0;
-			event.xclient.data.l[1] = 0;
-			event.xclient.data.l[2] = 0;
-			event.xclient.data.l[3] = 0;
-			event.xclient.data.l[4] = 0;
-
-			XSendEvent( display, childs[n], True, NoEventMask, &event );
+			target = childs[n];
 
 			// exit loop but not without freeing resources below
 			n = 0;
@@ -358,27 +876,34 @@ void Dock::send( const char *message, const char *data, int len )
 	if( childs )
 		XFree( childs );
 
-	XCloseDisplay( display );
+	return target;
 }
 
 /**
- * Change icon of a command (remotely)
+ * Return name of the selection a dock owns on a screen
  *
- * @param cmd - command of icon to change
- * @param icon - new icon
+ * @param screen - screen number
  */
-void Dock::changeIcon( const char *cmd, const char *icon )
+string Dock::getSelectionName( int screen )
 {
-	if( !cmd || !*cmd ||
-		!icon || !*icon )
-		return;
+	char buf[32];
 
-	string data = cmd;
+	snprintf( buf, sizeof( buf ), "%s%d", SelectionPrefix, screen );
 
-	data += ":";
-	data += icon;
+	return buf;
+}
+
+/**
+ * Change icons of any number of commands (remotely) with one message
+ *
+ * @param changes - lines of COMMAND:IMAGEFILE
+ */
+void Dock::changeIcons( const string &changes )
+{
+	if( changes.empty() )
+		return;
 
-	Dock::send( ChangeIconMessage, data.c_str(), data.length() );
+	Dock::send( ChangeIconMessage, changes.c_str(), changes.length() );
 }
 
 /**
@@ -394,6 +919,391 @@ void Dock::executeIcon( const char *cmd )
 	Dock::send( ExecuteIconMessage, cmd, strlen( cmd ) );
 }
 
+/**
+ * Change icon of the slot with the given command, returns false if
+ * there is no such slot
+ *
+ * @param cmd - command of icon to change or #ID of slot
+ * @param icon - new icon
+ */
+bool Dock::setIcon( const char *cmd, const char *icon )
+{
+	Slot *slot;
+
+	if( !(slot = getSlot( cmd )) )
+		return false;
+
+	// the current image stays until the new one is decoded
+	if( strcasecmp( slot->getIcon(), icon ) )
+	{
+		// a broken icon from outside must not take the dock down
+		started = true;
+
+		slot->setIcon( icon );
+		assign( slot );
+	}
+
+	return true;
+}
+
+/**
+ * Execute the slot with the given command, returns false if there
+ * is no such slot
+ *
+ * @param cmd - command of icon to execute or #ID of slot
+ */
+bool Dock::execute( const char *cmd )
+{
+	Slot *slot;
+
+	if( !(slot = getSlot( cmd )) )
+		return false;
+
+	slot->exec();
+
+	return true;
+}
+
+/**
+ * Return slot by command or by id if cmd is of the form #ID
+ *
+ * @param cmd - command of icon or #ID of slot
+ */
+Slot *Dock::getSlot( const char *cmd )
+{
+	if( !cmd )
+		return 0;
+
+	// a '#' can't be part of a command since it starts a comment
+	if( *cmd == '#' )
+	{
+		char *end;
+		long id = strtol( cmd+1, &end, 10 );
+
+		if( end == cmd+1 ||
+			*end ||
+			id < 0 ||
+			id >= (long) slots.size() )
+			return 0;
+
+		return slots[id];
+	}
+
+	map<string, Slot *>::iterator it;
+
+	if( (it = commands.find( fold( cmd ) )) == commands.end() )
+		return 0;
+
+	return it->second;
+}
+
+/**
+ * Capture the backgrounds of all invalid slots with one request per
+ * parent window and draw them
+ */
+void Dock::refresh()
+{
+	invalidated = false;
+
+	map<Window, vector<Slot *> > parents;
+
+	for( int n = 0, size = slots.size(); n < size; ++n )
+	{
+		Slot *slot = slots[n];
+
+		if( !slot->hasImage() ||
+			!slot->isInvalid() )
+			continue;
+
+		// the window may have been reparented before it was watched
+		if( !slot->getParent() )
+		{
+			Window root;
+			Window parent = 0;
+			Window *children;
+			unsigned int count;
+			XWindowAttributes wa;
+
+			if( XQueryTree( display, slot->getWindow(), &root, &parent,
+					&children, &count ) &&
+				children )
+				XFree( children );
+
+			if( parent &&
+				XGetWindowAttributes( display, slot->getWindow(), &wa ) )
+				slot->setGeometry( parent, wa.x, wa.y );
+		}
+
+		parents[slot->getParent()].push_back( slot );
+	}
+
+	map<Window, vector<Slot *> >::iterator it = parents.begin();
+	map<Window, vector<Slot *> >::iterator end = parents.end();
+	XErrorHandler handler = XSetErrorHandler( Dock::ignoreError );
+
+	for( ; it != end; ++it )
+	{
+		vector<Slot *> &group = it->second;
+		vector<Slot *> uncovered;
+		XImage *capture = 0;
+		XWindowAttributes wa;
+		int l = 0;
+		int t = 0;
+
+		// XGetImage fails if the parent is not completely on screen
+		if( it->first &&
+			XGetWindowAttributes( display, it->first, &wa ) &&
+			wa.map_state == IsViewable &&
+			wa.x >= 0 &&
+			wa.y >= 0 &&
+			wa.x+wa.width <= screenwidth &&
+			wa.y+wa.height <= screenheight )
+		{
+			int r = 0;
+			int b = 0;
+
+			l = wa.width;
+			t = wa.height;
+
+			for( vector<Slot *>::iterator s = group.begin();
+				s != group.end(); ++s )
+			{
+				int x = (*s)->getX()+(*s)->getLeft();
+				int y = (*s)->getY()+(*s)->getTop();
+
+				l = std::min( l, x );
+				t = std::min( t, y );
+				r = std::max( r, x+(*s)->getWidth() );
+				b = std::max( b, y+(*s)->getHeight() );
+
+				// let the window show the background of its parent
+				XClearWindow( display, (*s)->getWindow() );
+			}
+
+			l = std::max( l, 0 );
+			t = std::max( t, 0 );
+			r = std::min( r, wa.width );
+			b = std::min( b, wa.height );
+
+			if( r > l &&
+				b > t )
+				capture = XGetImage( display, it->first, l, t, r-l, b-t,
+					AllPlanes, ZPixmap );
+		}
+
+		// obscured parts of a capture are taken again when they
+		// become visible since the parent may be anything but the
+		// wallpaper
+		for( vector<Slot *>::iterator s = group.begin();
+			s != group.end(); ++s )
+			if( capture )
+				(*s)->setBackground( capture, 
+					(*s)->getX()+(*s)->getLeft()-l, 
+					(*s)->getY()+(*s)->getTop()-t,
+					(*s)->getVisibility() == VisibilityUnobscured );
+			else
+				uncovered.push_back( *s );
+
+		// slots of parents that can't be captured at all show the
+		// wallpaper
+		XImage *fallback = 0;
+		int fl = 0;
+		int ft = 0;
+
+		if( !uncovered.empty() &&
+			it->first &&
+			getWallpaper() )
+		{
+			Window child;
+			int px;
+			int py;
+
+			if( XTranslateCoordinates( display, it->first, 
+				RootWindow( display, screen ), 0, 0, &px, &py, &child ) )
+			{
+				int r = 0;
+				int b = 0;
+
+				fl = wallpaperwidth;
+				ft = wallpaperheight;
+
+				for( vector<Slot *>::iterator s = uncovered.begin();
+					s != uncovered.end(); ++s )
+				{
+					int x = px+(*s)->getX()+(*s)->getLeft();
+					int y = py+(*s)->getY()+(*s)->getTop();
+
+					fl = std::min( fl, x );
+					ft = std::min( ft, y );
+					r = std::max( r, x+(*s)->getWidth() );
+					b = std::max( b, y+(*s)->getHeight() );
+				}
+
+				fl = std::max( fl, 0 );
+				ft = std::max( ft, 0 );
+				r = std::min( r, (int) wallpaperwidth );
+				b = std::min( b, (int) wallpaperheight );
+
+				if( r > fl &&
+					b > ft )
+					fallback = XGetImage( display, wallpaper, 
+						fl, ft, r-fl, b-ft, AllPlanes, ZPixmap );
+
+				// make offsets relative to the parent again
+				fl -= px;
+				ft -= py;
+			}
+		}
+
+		for( vector<Slot *>::iterator s = uncovered.begin();
+			s != uncovered.end(); ++s )
+			if( fallback )
+				(*s)->setBackground( fallback, 
+					(*s)->getX()+(*s)->getLeft()-fl, 
+					(*s)->getY()+(*s)->getTop()-ft, true );
+			else
+				(*s)->setBackground( 0, 0, 0, false );
+
+		if( fallback )
+			XDestroyImage( fallback );
+
+		if( capture )
+			XDestroyImage( capture );
+	}
+
+	XSetErrorHandler( handler );
+}
+
+/**
+ * Return the root window pixmap set by most wallpaper setters, 0 if
+ * there is none
+ */
+Pixmap Dock::getWallpaper()
+{
+	if( wallpaperchecked )
+		return wallpaper;
+
+	wallpaperchecked = true;
+	wallpaper = 0;
+
+	Property <Pixmap> p;
+	Window root;
+	int x;
+	int y;
+	unsigned int border;
+	unsigned int depth;
+
+	if( !p.getProperty( display, RootWindow( display, screen ), 
+			XA_PIXMAP, "_XROOTPMAP_ID" ) ||
+		!XGetGeometry( display, *p.getData(), &root, &x, &y, 
+			&wallpaperwidth, &wallpaperheight, &border, &depth ) ||
+		depth != (unsigned int) DefaultDepth( display, screen ) )
+		return 0;
+
+	return (wallpaper = *p.getData());
+}
+
+/**
+ * Error handler that ignores errors of requests for windows and
+ * pixmaps that may have gone away
+ */
+int Dock::ignoreError( Display *, XErrorEvent * )
+{
+	return 0;
+}
+
+/**
+ * Return the slot of a window, 0 if there is none
+ *
+ * @param w - window
+ */
+Slot *Dock::getSlot( Window w )
+{
+	// window ids are kept in an array of their own to make this
+	// lookup for every event cheap
+	for( int n = 0, size = windows.size(); n < size; ++n )
+		if( windows[n] == w )
+			return slots[n];
+
+	return 0;
+}
+
+/**
+ * Return lower case copy of a string
+ *
+ * @param s - string to fold
+ */
+string Dock::fold( const char *s )
+{
+	string f = s;
+	string::iterator it = f.begin();
+	string::iterator end = f.end();
+
+	for( ; it != end; ++it )
+		*it = tolower( (unsigned char) *it );
+
+	return f;
+}
+
+/**
+ * Append one line per slot describing its state, in order of addition
+ *
+ * @param s - string to append to
+ */
+void Dock::getState( string &s )
+{
+	for( int n = 0, size = slots.size(); n < size; ++n )
+		slots[n]->getState( s );
+}
+
+/**
+ * Append launch latencies of all slots
+ *
+ * @param s - string to append to
+ */
+void Dock::getStats( string &s )
+{
+	for( int n = 0, size = slots.size(); n < size; ++n )
+		slots[n]->getStats( s );
+}
+
+/**
+ * Returns true if anyone is listening to notifications
+ */
+const bool Dock::isObserved() const
+{
+	return control && control->hasSubscribers();
+}
+
+/**
+ * Tell subscribers about an event of a slot
+ *
+ * @param event - name of event
+ * @param id - id of slot
+ * @param data - event data (optional)
+ */
+void Dock::notify( const char *event, int id, const string &data )
+{
+	if( !isObserved() )
+		return;
+
+	char buf[64];
+
+	snprintf( buf, sizeof( buf ), "event\t%s\t%d", event, id );
+
+	string line = buf;
+
+	if( !data.empty() )
+	{
+		line += "\t";
+		line += data;
+	}
+
+	line += "\n";
+
+	control->broadcast( line );
+}
+
 /**
  * Process a client message
  *
@@ -407,54 +1317,201 @@ void Dock::client( XEvent *e )
 		e->xclient.message_type )) )
 		return;
 
-	Atom returnedtype;
-	int format;
-	unsigned long n;
-	unsigned long bytesafter;
-	char *prop;
+	Property <char> p;
 
-	if( XGetWindowProperty( display, e->xany.window, e->xclient.message_type, 
-		0, 1024, False, e->xclient.message_type, &returnedtype, &format, &n, 
-		&bytesafter, (unsigned char **) &prop ) != Success )
+	if( !p.getProperty( display, e->xany.window, e->xclient.message_type, 
+		e->xclient.message_type ) )
+	{
+		XFree( msg );
 		return;
+	}
+
+	char *prop = p.getData();
 
 	if( !strcmp( msg, ChangeIconMessage ) )
 	{
-		char *cmd;
-		char *icon;
+		// one message may carry a COMMAND:IMAGEFILE line for any
+		// number of slots, drawings are flushed together
+		for( char *line = prop, *next; line && *line; line = next )
+		{
+			char *icon;
+
+			if( (next = strchr( line, '\n' )) )
+				*(next++) = 0;
+
+			if( !(icon = strchr( line, ':' )) )
+				continue;
+
+			*(icon++) = 0;
+
+			if( *line && *icon )
+				setIcon( line, icon );
+		}
+
+		XFlush( display );
+	}
+	else if( !strcmp( msg, ExecuteIconMessage ) )
+		execute( prop );
+
+	XDeleteProperty( display, e->xany.window, e->xclient.message_type );
+
+	XFree( msg );
+}
+
+/**
+ * Hand decoded images over to all slots that still show them
+ */
+void Dock::update()
+{
+	for( Decoder::Job job; decoder->fetch( job ); )
+	{
+		vector<Slot *> showing;
+
+		for( int n = 0, size = slots.size(); n < size; ++n )
+			if( job.getFile() == slots[n]->getIcon() )
+				showing.push_back( slots[n] );
+
+		// drop results for images that were replaced in the meantime
+		if( showing.empty() )
+		{
+			if( job.getImage() )
+				job.getImage()->release();
+
+			continue;
+		}
 
-		if( (cmd = strtok( prop, ":" )) &&
-			(icon = strtok( 0, "\n" )) )
+		if( job.getError() )
 		{
-			Slot *slot;
+			// an icon that can't be shown on startup is a
+			// configuration error
+			if( !started )
+				throw job.getError();
 
-			for( slot = first;
-				slot;
-				slot = slot->getNext() )
-				if( !strcasecmp( slot->getCommand(), cmd ) && 
-					strcasecmp( slot->getIcon(), icon ) )
+			// but once running the dock should not go down because
+			// of a broken icon file
+			cerr << job.getFile() << ": " << job.getError() << endl;
+
+			// a slot without an image is of no use
+			bool removed = false;
+
+			for( int n = showing.size(); n--; )
+				if( !showing[n]->hasImage() )
 				{
-					slot->setIcon( icon );
-					break;
+					remove( showing[n] );
+					removed = true;
 				}
+
+			if( removed )
+				renumber();
+
+			continue;
 		}
+
+		Image *image = Repository::put( job.getFile(), getSlotWidth(), 
+			getSlotHeight(), getScale(), job.getStatus(), job.getImage() );
+
+		// every slot takes its own reference
+		for( int n = showing.size(); n--; )
+			showing[n]->setImage( image->acquire() );
+
+		image->release();
 	}
-	else if( !strcmp( msg, ExecuteIconMessage ) )
+
+	// startup is over when every slot got its first image
+	if( !started )
 	{
-		Slot *slot;
+		started = true;
 
-		for( slot = first;
-			slot;
-			slot = slot->getNext() )
-			if( !strcasecmp( slot->getCommand(), prop ) )
+		for( int n = slots.size(); n--; )
+			if( !slots[n]->hasImage() )
 			{
-				slot->exec();
+				started = false;
 				break;
 			}
 	}
+}
 
-	XFree( prop );
-	XDeleteProperty( display, e->xany.window, e->xclient.message_type );
+/**
+ * Decode changed image files again for all slots showing them and
+ * apply changes of the configuration file
+ */
+void Dock::reload()
+{
+	vector<string> changed;
 
-	XFree( msg );
+	watcher->fetch( changed );
+
+	vector<string>::iterator it = changed.begin();
+	vector<string>::iterator end = changed.end();
+
+	for( ; it != end; ++it )
+	{
+		if( *it == rcfile )
+		{
+			started = true;
+			load( rcfile );
+			continue;
+		}
+
+		Repository::forget( *it );
+
+		vector<Slot *>::iterator sit = slots.begin();
+		vector<Slot *>::iterator send = slots.end();
+
+		// one decode serves all slots showing the file
+		for( ; sit != send; ++sit )
+			if( *it == (*sit)->getIcon() )
+			{
+				decoder->decode( *it, true );
+				break;
+			}
+	}
+}
+
+/**
+ * Find the slot whose application got activated
+ *
+ * @param active - active window
+ */
+void Dock::updateFocus( Window active )
+{
+	Slot *slot = 0;
+
+	for( int n = 0, size = slots.size(); n < size; ++n )
+		if( slots[n]->hasFocus( active ) )
+		{
+			slot = slots[n];
+			break;
+		}
+
+	if( slot == focused )
+		return;
+
+	if( (focused = slot) )
+		notify( "focused", slot->getId() );
+}
+
+/**
+ * Return scale factor for the screen resolution from the Xft.dpi
+ * resource, 1 if there is none
+ *
+ * @param d - display
+ */
+float Dock::getScaleFactor( Display *d )
+{
+	const char *resources;
+
+	if( !(resources = XResourceManagerString( d )) )
+		return 1;
+
+	for( const char *p = resources; (p = strstr( p, "Xft.dpi:" )); p++ )
+		if( p == resources ||
+			p[-1] == '\n' )
+		{
+			float dpi = atof( p+8 );
+
+			return dpi > 0 ? dpi/96 : 1;
+		}
+
+	return 1;
 }
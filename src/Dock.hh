@@ -31,28 +31,40 @@
 
 #include <unistd.h>
 #include <string>
+#include <vector>
+#include <map>
 
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 
+#include "Arena.hh"
 #include "Icon.hh"
 #include "Render.hh"
 
 namespace bbdock
 {
 	// forward declaration
+	class Control;
+	class Decoder;
 	class Slot;
+	class Watcher;
 
 	/**
 	 * Dock manages a number of Slot object
 	 *
 	 * @author mf@markusfisch.de
-	 * @version 0.1.6
+	 * @version 0.2.5
 	 */
 	class Dock
 	{
 		public:
 			inline const int &getBitsPerPixel() const { return bitsperpixel; }
+			inline Visual *getVisual() const { return visual; }
+			inline const int &getDepth() const { return depth; }
+			inline const Colormap &getColormap() const { return colormap; }
+			inline const bool &hasAlpha() const { return alpha; }
+			inline Arena &getArena() { return arena; }
+			inline const void invalidate() { invalidated = true; }
 			inline Display *getDisplay() const { return display; }
 			inline const int &getScreen() const { return screen; }
 			inline const GC &getGC() const { return gc; }
@@ -68,6 +80,8 @@ namespace bbdock
 				return settings.getMarkLeft(); }
 			inline const int &getMarkTop() const { 
 				return settings.getMarkTop(); }
+			inline const float &getScale() const { 
+				return settings.getScale(); }
 			inline const bool &getCaseSensitive() const { 
 				return settings.getCaseSensitive(); }
 
@@ -99,6 +113,9 @@ namespace bbdock
 						{ return leftclickaction; }
 					inline const bool &getCaseSensitive() const { 
 						return casesensitive; }
+					inline const float &getScale() const { return scale; }
+					inline const bool &getCompositing() const { 
+						return compositing; }
 					inline const void setSlotWidth( int w ) { slotwidth = w; }
 					inline const void setSlotHeight( int h ) { slotheight = h; }
 					inline const void setMarkType( Render::MarkType t ) { 
@@ -111,6 +128,9 @@ namespace bbdock
 						ClickAction a ) { leftclickaction = a; }
 					inline const void setCaseSensitive( bool c ) { 
 						casesensitive = c; }
+					inline const void setScale( float s ) { scale = s; }
+					inline const void setCompositing( bool c ) { 
+						compositing = c; }
 
 					Settings() :
 						slotwidth( 64 ),
@@ -120,7 +140,9 @@ namespace bbdock
 						marktop( 0 ),
 						rightclickaction( IconifyApplication ),
 						leftclickaction( DoNothing ),
-						casesensitive( false ) {}
+						casesensitive( false ),
+						scale( 0 ),
+						compositing( false ) {}
 					virtual ~Settings() {}
 
 				private:
@@ -132,14 +154,24 @@ namespace bbdock
 					ClickAction rightclickaction;
 					ClickAction leftclickaction;
 					bool casesensitive;
+					float scale;
+					bool compositing;
 			};
 
 			Dock( Dock::Settings & );
 			virtual ~Dock();
 			virtual bool add( Icon * );
+			virtual bool load( const std::string & );
 			virtual void run();
+			virtual bool setIcon( const char *, const char * );
+			virtual bool execute( const char * );
+			virtual void getState( std::string & );
+			virtual void getStats( std::string & );
+			virtual const bool isObserved() const;
+			virtual void notify( const char *, int, 
+				const std::string & = "" );
 			static void send( const char *, const char *, int );
-			static void changeIcon( const char *, const char * );
+			static void changeIcons( const std::string & );
 			static void executeIcon( const char * );
 
 			enum
@@ -150,17 +182,59 @@ namespace bbdock
 		private:
 			static const char *ChangeIconMessage;
 			static const char *ExecuteIconMessage;
+			static const char *SelectionPrefix;
+			static int signals[2];
 
 			Display *display;
 			int screen;
 			GC gc;
+			Window window;
 			int bitsperpixel;
+			Visual *visual;
+			int depth;
+			Colormap colormap;
+			bool alpha;
 			int screenwidth;
 			int screenheight;
 			Dock::Settings settings;
-			Slot *first;
+			Arena arena;
+			std::vector<Slot *> slots;
+			std::vector<Window> windows;
+			std::map<std::string, Slot *> commands;
+			Control *control;
+			Decoder *decoder;
+			Watcher *watcher;
+			std::string rcfile;
+			std::vector<pid_t> orphans;
+			Slot *focused;
+			Atom activewindow;
+			Atom clientlist;
+			bool invalidated;
+			Atom rootpixmap;
+			Pixmap wallpaper;
+			unsigned int wallpaperwidth;
+			unsigned int wallpaperheight;
+			bool wallpaperchecked;
+			bool started;
 
 			void client( XEvent * );
+			void updateFocus( Window );
+			void update();
+			void reload();
+			void configure( std::vector<Icon *> & );
+			void remove( Slot * );
+			void renumber();
+			void assign( Slot * );
+			void refresh();
+			Pixmap getWallpaper();
+			static int ignoreError( Display *, XErrorEvent * );
+			static void hangup( int );
+			Slot *getSlot( const char * );
+			Slot *getSlot( Window );
+			static std::string fold( const char * );
+			static Window find( Display *, int, const char *, Atom & );
+			static std::string getSelectionName( int );
+			static float getScaleFactor( Display * );
 	};
 }
 
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2006 Markus Fisch
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Markus Fisch nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <time.h>
+#include <stdio.h>
+#include <string>
+
+#include "Histogram.hh"
+
+using namespace std;
+using namespace bbdock;
+
+/**
+ * Initialize object
+ */
+Histogram::Histogram() :
+	count( 0 ),
+	min( 0 ),
+	max( 0 )
+{
+	for( int n = Buckets; n--; )
+		buckets[n] = 0;
+}
+
+/**
+ * Add a duration
+ *
+ * @param us - duration in microseconds
+ */
+void Histogram::add( long long us )
+{
+	if( us < 0 )
+		us = 0;
+
+	if( !count++ ||
+		us < min )
+		min = us;
+
+	if( us > max )
+		max = us;
+
+	int n = 0;
+
+	for( ; us > 1 && n < Buckets-1; us >>= 1 )
+		++n;
+
+	++buckets[n];
+}
+
+/**
+ * Append tab-separated fields: number of samples, minimum, maximum and
+ * a comma-separated list of the buckets up to the last one used
+ *
+ * @param s - string to append to
+ */
+void Histogram::get( string &s ) const
+{
+	char buf[64];
+
+	snprintf( buf, sizeof( buf ), "%lu\t%lld\t%lld\t", count, min, max );
+	s += buf;
+
+	int used = Buckets;
+
+	while( used > 1 &&
+		!buckets[used-1] )
+		--used;
+
+	for( int n = 0; n < used; ++n )
+	{
+		snprintf( buf, sizeof( buf ), "%s%lu", (n ? "," : ""), 
+			buckets[n] );
+		s += buf;
+	}
+}
+
+/**
+ * Return time of a monotonic clock in microseconds
+ */
+long long Histogram::now()
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return (long long) ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
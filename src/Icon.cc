@@ -30,6 +30,8 @@
 #include <vector>
 
 #include <stdlib.h>
+#include <string.h>
+#include <strings.h>
 
 #include "Icon.hh"
 
@@ -43,13 +45,101 @@ using namespace bbdock;
  * @param c - command to execute
  * @param w - window title if application should run exclusively (optional)
  * @param ms - idle time in miliseconds (optional)
+ * @param p - seconds after start to launch the application in the
+ *            background, -1 to not do that (optional)
  */
-Icon::Icon( string i, string c, string t, unsigned int ms ) :
+Icon::Icon( string i, string c, string t, unsigned int ms, int p ) :
 	image( expand( i ) ),
 	command( expand( c ) ),
-	idletime( ms )
+	idletime( ms ),
+	prelaunch( p )
 {
 	setTitle( t );
+	prepare();
+}
+
+/**
+ * Create an Icon from a record, returns 0 if the record is invalid
+ *
+ * @param record - an icon record, gets modified
+ * @param delimiter - field delimiter
+ */
+Icon *Icon::parse( char *record, const char delimiter )
+{
+	// cut off comments, don't use strtok because it will skip leading
+	// delimiters
+	{
+		char *comment;
+
+		if( (comment = strchr( record, '#' )) )
+			*comment = 0;
+	}
+
+	enum
+	{
+		Image,
+		Command,
+		Title,
+		Idle,
+		Prelaunch
+	};
+
+	char *fields[Prelaunch+1];
+
+	bzero( fields, sizeof( fields ) );
+	fields[Image] = record;
+
+	for( int n = Image; n < Prelaunch; )
+	{
+		char *stop;
+
+		if( !(stop = strchr( fields[n], delimiter )) )
+			break;
+
+		*(stop++) = 0;
+		fields[++n] = stop;
+	}
+
+	if( !fields[Image] || 
+		!fields[Command] )
+		return 0;
+
+	unsigned int idletime = Slow;
+
+	if( fields[Idle] )
+	{
+		if( !strcasecmp( fields[Idle], "fast" ) )
+			idletime = Fast;
+		else if( !strcasecmp( fields[Idle], "fastest" ) )
+			idletime = Fastest;
+		else if( !strcasecmp( fields[Idle], "slow" ) )
+			idletime = Slow;
+		else if( !strcasecmp( fields[Idle], "lame" ) )
+			idletime = Lame;
+		else 
+		{
+			unsigned int t = (unsigned int) 
+				atoi( fields[Idle] );
+
+			if( t > 0 )
+				idletime = t;
+		}
+	}
+
+	// a delay in seconds or "now"
+	int prelaunch = -1;
+
+	if( fields[Prelaunch] &&
+		*fields[Prelaunch] )
+	{
+		if( !strcasecmp( fields[Prelaunch], "now" ) )
+			prelaunch = 0;
+		else if( (prelaunch = atoi( fields[Prelaunch] )) < 0 )
+			prelaunch = -1;
+	}
+
+	return new Icon( fields[Image], fields[Command], 
+		(fields[Title] ? fields[Title] : ""), idletime, prelaunch );
 }
 
 /**
@@ -65,6 +155,40 @@ string Icon::expand( string path ) const
 	return path;
 }
 
+/**
+ * Split command into arguments if it can run without a shell,
+ * arguments stay empty otherwise
+ */
+void Icon::prepare()
+{
+	// builtins and reserved words of the shell don't exist as files
+	static const char *words[] = {
+		".", ":", "alias", "break", "case", "cd", "command", "continue",
+		"do", "done", "elif", "else", "esac", "eval", "exec", "exit",
+		"export", "fi", "for", "getopts", "hash", "if", "in", "local",
+		"read", "readonly", "return", "select", "set", "shift", "source",
+		"then", "times", "trap", "type", "typeset", "ulimit", "umask",
+		"unalias", "unset", "until", "wait", "while", 0 };
+
+	arguments.clear();
+
+	if( command.find_first_of( "|&;<>()$`\\\"'*?[]{}#~=%!\n" ) != 
+		string::npos )
+		return;
+
+	tokenize( command, arguments, " \t" );
+
+	if( arguments.empty() )
+		return;
+
+	for( const char **w = words; *w; w++ )
+		if( arguments[0] == *w )
+		{
+			arguments.clear();
+			break;
+		}
+}
+
 /**
  * Tokenize string into vector
  *
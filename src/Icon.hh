@@ -38,20 +38,23 @@ namespace bbdock
 	 * A icon/command pair
 	 *
 	 * @author mf@markusfisch.de
-	 * @version 0.1.4
+	 * @version 0.1.7
 	 */
 	class Icon
 	{
 		public:
 			inline const std::string &getCommand() const { return command; }
+			inline const std::vector<std::string> &getArguments() const {
+				return arguments; }
 			inline const std::string &getImage() const { return image; }
 			inline const std::vector<std::string> &getTitle() const { 
 				return title; }
 			inline const bool &isExclusive() const { return exclusive; }
 			inline const unsigned int &getIdleTime() const { 
 				return idletime; }
+			inline const int &getPrelaunch() const { return prelaunch; }
 			inline const void setCommand( const std::string s ) { 
-				command = expand( s ); }
+				command = expand( s ); prepare(); }
 			inline const void setImage( const std::string s ) { 
 				image = expand( s ); }
 			inline const void setTitle( const std::string s )
@@ -66,6 +69,7 @@ namespace bbdock
 			inline const void isExclusive( bool e ) { exclusive = e; }
 			inline const void setIdleTime( unsigned int t ) { 
 				idletime = t; }
+			inline const void setPrelaunch( int p ) { prelaunch = p; }
 
 			enum
 			{
@@ -76,17 +80,21 @@ namespace bbdock
 			};
 
 			Icon( const std::string, const std::string, 
-				const std::string, unsigned int = Slow );
+				const std::string, unsigned int = Slow, int = -1 );
 			virtual ~Icon() {}
+			static Icon *parse( char *, const char );
 
 		private:
 			std::string command;
+			std::vector<std::string> arguments;
 			std::string image;
 			std::vector<std::string> title;
 			bool exclusive;
 			unsigned int idletime;
+			int prelaunch;
 
 			std::string expand( std::string ) const;
+			void prepare();
 			void tokenize( const std::string str, 
 				std::vector<std::string> &, 
 				const std::string & = " " ) const;
@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) 2006 Markus Fisch
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Markus Fisch nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include <png.h>
+
+#include "Image.hh"
+
+using namespace std;
+using namespace bbdock;
+
+/**
+ * Load PNG file
+ *
+ * @param file - path and filename of PNG file
+ */
+Image::Image( const string &file ) :
+	width( 0 ),
+	height( 0 ),
+	pixels( 0 ),
+	mapping( 0 ),
+	length( 0 ),
+	references( 1 )
+{
+	png_structp png = 0;
+	png_infop info = 0;
+	FILE *fp;
+	volatile bool failed = false;
+
+	// everything that is changed after setjmp() must be volatile,
+	// so the file is opened before
+	if( !(fp = fopen( file.c_str(), "rb" )) )
+		throw "Invalid image file !";
+
+	if( !(png = png_create_read_struct( PNG_LIBPNG_VER_STRING,
+		0, 0, 0 )) )
+	{
+		fclose( fp );
+		throw "PNG library error !";
+	}
+
+	try
+	{
+		if( !(info = png_create_info_struct( png )) ||
+			setjmp( png_jmpbuf( png ) ) )
+			throw 0;
+
+		// let libpng reject images no icon needs to be before any
+		// pixels get allocated
+		png_set_user_limits( png, MaxSize, MaxSize );
+		png_init_io( png, fp );
+		png_read_info( png, info );
+
+		int type = png_get_color_type( png, info );
+
+		// let libpng convert every format into 8 bit BGRA rows so
+		// they can be read straight into the pixel buffer
+		png_set_expand( png );
+
+		if( png_get_bit_depth( png, info ) == 16 )
+			png_set_strip_16( png );
+
+		if( type == PNG_COLOR_TYPE_GRAY ||
+			type == PNG_COLOR_TYPE_GRAY_ALPHA )
+			png_set_gray_to_rgb( png );
+
+		png_set_add_alpha( png, 0xff, PNG_FILLER_AFTER );
+		png_set_bgr( png );
+
+		int passes = png_set_interlace_handling( png );
+
+		png_read_update_info( png, info );
+
+		width = png_get_image_width( png, info );
+		height = png_get_image_height( png, info );
+
+		if( !width ||
+			!height ||
+			width > MaxSize ||
+			height > MaxSize ||
+			png_get_rowbytes( png, info ) != (png_size_t) width<<2 ||
+			!(pixels = new int[width*height]) )
+			throw 0;
+
+		// interlaced images update the same rows on every pass
+		for( ; passes--; )
+			for( int y = 0, *row = pixels; 
+				y < height; 
+				y++, row += width )
+				png_read_row( png, (png_bytep) row, 0 );
+
+		png_read_end( png, 0 );
+	}
+	catch( int )
+	{
+		// when failed do nothing, first the file needs to be closed
+		failed = true;
+	}
+
+	// free possibly allocated resources
+	fclose( fp );
+
+	png_destroy_read_struct( &png, &info, (png_infopp) 0 );
+
+	if( failed || !pixels )
+	{
+		delete[] pixels;
+		throw "Invalid image file !";
+	}
+}
+
+/**
+ * Take over pixels that are either allocated with new[] or part
+ * of a memory mapping
+ *
+ * @param w - width in pixels
+ * @param h - height in pixels
+ * @param p - pixels
+ * @param m - start of memory mapping containing p (optional)
+ * @param l - length of memory mapping (optional)
+ */
+Image::Image( int w, int h, int *p, void *m, size_t l ) :
+	width( w ),
+	height( h ),
+	pixels( p ),
+	mapping( m ),
+	length( l ),
+	references( 1 )
+{
+}
+
+/**
+ * Return a reference to an image that is scaled by the given factor
+ * and fits into the given size; that is this image if it does
+ * already or a resampled copy otherwise
+ *
+ * @param maxwidth - maximum width in pixels
+ * @param maxheight - maximum height in pixels
+ * @param scale - scale factor (optional)
+ */
+Image *Image::fit( int maxwidth, int maxheight, float scale )
+{
+	if( maxwidth < 1 ||
+		maxheight < 1 ||
+		scale <= 0 )
+		throw "Invalid image size !";
+
+	int w = (int) (width*scale+.5f);
+	int h = (int) (height*scale+.5f);
+
+	// keep aspect ratio
+	if( w > maxwidth ||
+		h > maxheight )
+	{
+		w = maxwidth;
+		h = maxheight;
+
+		if( (long long) width*maxheight > (long long) height*maxwidth )
+			h = height*maxwidth/width;
+		else
+			w = width*maxheight/height;
+	}
+
+	if( w < 1 )
+		w = 1;
+
+	if( h < 1 )
+		h = 1;
+
+	if( w == width &&
+		h == height )
+		return acquire();
+
+	if( w > width ||
+		h > height )
+		return enlarge( w, h );
+
+	return shrink( w, h );
+}
+
+/**
+ * Return a copy scaled down with a box filter
+ *
+ * @param w - width in pixels, not larger than the width of this image
+ * @param h - height in pixels, not larger than the height of this image
+ */
+Image *Image::shrink( int w, int h ) const
+{
+	// every source pixel covers one or two target pixels per axis;
+	// colors are weighted by alpha so transparent pixels don't darken
+	// the edges
+	int rowlength = w*4;
+	float *row = new float[rowlength];
+	float *sum = new float[rowlength*h];
+	const float xscale = 1.0f/width;
+	const float yscale = 1.0f/height;
+
+	for( int n = rowlength*h; n--; )
+		sum[n] = 0;
+
+	for( int y = 0; y < height; ++y )
+	{
+		const unsigned char *src = 
+			(const unsigned char *) (pixels+y*width);
+
+		for( int n = rowlength; n--; )
+			row[n] = 0;
+
+		for( int x = 0; x < width; ++x, src += 4 )
+		{
+			float a = src[3];
+			float b = src[0]*a;
+			float g = src[1]*a;
+			float r = src[2]*a;
+			int tx = x*w/width;
+			int edge = (tx+1)*width-x*w;
+			float wa = (edge < w ? edge : w)*xscale;
+			float *dst = row+tx*4;
+
+			dst[0] += b*wa;
+			dst[1] += g*wa;
+			dst[2] += r*wa;
+			dst[3] += a*wa;
+
+			if( edge < w )
+			{
+				float wb = (w-edge)*xscale;
+
+				dst[4] += b*wb;
+				dst[5] += g*wb;
+				dst[6] += r*wb;
+				dst[7] += a*wb;
+			}
+		}
+
+		// add whole rows to keep the inner loops simple
+		int ty = y*h/height;
+		int edge = (ty+1)*height-y*h;
+		float wa = (edge < h ? edge : h)*yscale;
+		float *dst = sum+ty*rowlength;
+
+		for( int n = 0; n < rowlength; ++n )
+			dst[n] += row[n]*wa;
+
+		if( edge < h )
+		{
+			float wb = (h-edge)*yscale;
+
+			dst += rowlength;
+
+			for( int n = 0; n < rowlength; ++n )
+				dst[n] += row[n]*wb;
+		}
+	}
+
+	delete[] row;
+
+	int *p = new int[w*h];
+	unsigned char *dst = (unsigned char *) p;
+	const float *src = sum;
+
+	for( int n = w*h; n--; src += 4, dst += 4 )
+	{
+		float a = src[3];
+
+		if( a < 1.0f )
+		{
+			*((int *) dst) = 0;
+			continue;
+		}
+
+		dst[0] = (unsigned char) (src[0]/a+.5f);
+		dst[1] = (unsigned char) (src[1]/a+.5f);
+		dst[2] = (unsigned char) (src[2]/a+.5f);
+		dst[3] = (unsigned char) (a+.5f);
+	}
+
+	delete[] sum;
+
+	return new Image( w, h, p );
+}
+
+/**
+ * Return a copy scaled up with bilinear interpolation
+ *
+ * @param w - width in pixels
+ * @param h - height in pixels
+ */
+Image *Image::enlarge( int w, int h ) const
+{
+	// sample positions and weights of each column are the same for
+	// all rows
+	int *left = new int[w];
+	float *weight = new float[w];
+
+	for( int x = 0; x < w; ++x )
+	{
+		float sx = (x+.5f)*width/w-.5f;
+
+		if( sx < 0 )
+			sx = 0;
+
+		left[x] = (int) sx;
+		weight[x] = sx-left[x];
+
+		if( left[x] >= width-1 )
+		{
+			left[x] = width-1;
+			weight[x] = 0;
+		}
+	}
+
+	int *p = new int[w*h];
+	unsigned char *dst = (unsigned char *) p;
+
+	for( int y = 0; y < h; ++y )
+	{
+		float sy = (y+.5f)*height/h-.5f;
+
+		if( sy < 0 )
+			sy = 0;
+
+		int top = (int) sy;
+		float fy = sy-top;
+		int next = top < height-1 ? width : 0;
+		const unsigned char *row = 
+			(const unsigned char *) (pixels+top*width);
+
+		for( int x = 0; x < w; ++x, dst += 4 )
+		{
+			// interpolate alpha weighted colors like shrink() does
+			const unsigned char *s[4];
+			float f[4];
+			int right = weight[x] > 0 ? 4 : 0;
+
+			s[0] = row+left[x]*4;
+			s[1] = s[0]+right;
+			s[2] = s[0]+next*4;
+			s[3] = s[2]+right;
+			f[0] = (1-weight[x])*(1-fy);
+			f[1] = weight[x]*(1-fy);
+			f[2] = (1-weight[x])*fy;
+			f[3] = weight[x]*fy;
+
+			float b = 0;
+			float g = 0;
+			float r = 0;
+			float a = 0;
+
+			for( int n = 0; n < 4; ++n )
+			{
+				float sa = s[n][3]*f[n];
+
+				b += s[n][0]*sa;
+				g += s[n][1]*sa;
+				r += s[n][2]*sa;
+				a += sa;
+			}
+
+			if( a < 1.0f )
+			{
+				*((int *) dst) = 0;
+				continue;
+			}
+
+			dst[0] = (unsigned char) (b/a+.5f);
+			dst[1] = (unsigned char) (g/a+.5f);
+			dst[2] = (unsigned char) (r/a+.5f);
+			dst[3] = (unsigned char) (a+.5f);
+		}
+	}
+
+	delete[] weight;
+	delete[] left;
+
+	return new Image( w, h, p );
+}
+
+/**
+ * Free pixels
+ */
+Image::~Image()
+{
+	if( mapping )
+		munmap( mapping, length );
+	else
+		delete[] pixels;
+}
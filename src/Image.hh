@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2006 Markus Fisch
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Markus Fisch nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef bbdock_Image_hh
+#define bbdock_Image_hh
+
+#include <sys/types.h>
+#include <string>
+
+namespace bbdock
+{
+	/**
+	 * Decoded pixels of a PNG file in BGRA format; decoding touches
+	 * nothing but the file so images may be loaded on any thread,
+	 * pixels may also live in a read-only memory mapping; images are
+	 * immutable and reference counted so they can be shared; images
+	 * get resampled for the size of the dock when they are loaded;
+	 * files wider or higher than MaxSize are rejected
+	 *
+	 * @author mf@markusfisch.de
+	 * @version 0.0.3
+	 */
+	class Image
+	{
+		public:
+			inline const int &getWidth() const { return width; }
+			inline const int &getHeight() const { return height; }
+			inline int *getPixels() const { return pixels; }
+			inline const int &getReferences() const { 
+				return references; }
+			inline Image *acquire() { ++references; return this; }
+			inline const void release() { 
+				if( !--references ) delete this; }
+
+			enum
+			{
+				MaxSize = 4096
+			};
+
+			Image( const std::string & );
+			Image( int, int, int *, void * = 0, size_t = 0 );
+			virtual Image *fit( int, int, float = 1 );
+
+		protected:
+			virtual ~Image();
+
+		private:
+			int width;
+			int height;
+			int *pixels;
+			void *mapping;
+			size_t length;
+			int references;
+
+			Image *shrink( int, int ) const;
+			Image *enlarge( int, int ) const;
+			Image( const Image & );
+			Image &operator=( const Image & );
+	};
+}
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2006 Markus Fisch
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Markus Fisch nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef bbdock_Property_hh
+#define bbdock_Property_hh
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+
+namespace bbdock
+{
+	/**
+	 * Property reads a window property of arbitrary length; large
+	 * properties are fetched in chunks following bytesafter into one
+	 * buffer that is allocated only once per fetch; properties that
+	 * fit into one chunk take a single request
+	 *
+	 * @author mf@markusfisch.de
+	 * @version 0.0.2
+	 */
+	template <class T> class Property
+	{
+		public:
+			inline T *getData() const { return data; }
+			inline unsigned long getItems() const { return items; }
+
+			enum
+			{
+				Chunk = 1024 // = long words per request
+			};
+
+			Property() : data( 0 ), items( 0 ) {}
+			virtual ~Property()
+			{
+				free();
+			}
+			bool getProperty( Display *display, Window w, Atom type, 
+				const char *name )
+			{
+				return getProperty( display, w, type, 
+					XInternAtom( display, name, False ) );
+			}
+			bool getProperty( Display *display, Window w, Atom type, 
+				Atom name )
+			{
+				free();
+
+				Atom returnedtype;
+				int format;
+				unsigned long n;
+				unsigned long bytesafter;
+				unsigned char *chunk = 0;
+
+				// the first chunk tells how much is left, so small
+				// properties take a single request
+				if( XGetWindowProperty( display, w, name, 0, Chunk, False, 
+					type, &returnedtype, &format, &n, &bytesafter, 
+					&chunk ) != Success )
+					return false;
+
+				if( returnedtype != type ||
+					!format ||
+					!n )
+				{
+					if( chunk )
+						XFree( chunk );
+
+					return false;
+				}
+
+				// format 32 items are stored as longs on the client side
+				unsigned long unit = format>>3;
+				unsigned long size = (format == 32 ? sizeof( long ) : unit);
+				unsigned long total = n+bytesafter/unit;
+				unsigned char *buffer;
+
+				// terminate with a zero just like Xlib does
+				if( !(buffer = (unsigned char *) malloc( total*size+1 )) )
+				{
+					XFree( chunk );
+					return false;
+				}
+
+				memcpy( buffer, chunk, n*size );
+				XFree( chunk );
+
+				items = n;
+
+				for( long offset = (n*unit)>>2; 
+					bytesafter && items < total; )
+				{
+					int f;
+
+					if( XGetWindowProperty( display, w, name, offset, Chunk, 
+						False, type, &returnedtype, &f, &n, &bytesafter, 
+						&chunk ) != Success )
+						break;
+
+					if( returnedtype != type ||
+						f != format )
+					{
+						XFree( chunk );
+						break;
+					}
+
+					// property may have grown in the meantime
+					if( n > total-items )
+						n = total-items;
+
+					memcpy( buffer+items*size, chunk, n*size );
+					XFree( chunk );
+
+					items += n;
+					offset += (n*unit)>>2;
+
+					if( !n || !bytesafter )
+						break;
+				}
+
+				buffer[items*size] = 0;
+				data = reinterpret_cast<T *>(buffer);
+
+				return true;
+			}
+
+		private:
+			T *data;
+			unsigned long items;
+
+			const void free()
+			{
+				if( !data )
+					return;
+
+				::free( reinterpret_cast<void *>(data) );
+
+				data = 0;
+				items = 0;
+			}
+	};
+}
+
+#endif
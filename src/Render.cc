@@ -66,8 +66,12 @@ const Render::Mark Render::cross( 7, 7, (char []){
  * @param width - width of the image in pixels
  * @param height - height of the image in pixels
  */
-Render *Render::getInstance( int bitsperpixel, int width, int height )
+Render *Render::getInstance( int bitsperpixel, int width, int height,
+	bool alpha )
 {
+	if( alpha )
+		return (Render *) new RenderARGB( width, height );
+
 	switch( bitsperpixel )
 	{
 		default:
@@ -149,13 +153,66 @@ unsigned int Render::getOffset( int left, int top, Render::Mark &mark,
 		skip += top*bytesperline;
 
 	if( left < 0 && width-mark.getWidth()+(++left) >= 0 )
-		skip += bytesperline-((mark.getWidth()-left)*bytesperpixel);
+		skip += bytesperline-padding-
+			((mark.getWidth()-left)*bytesperpixel);
 	else if( left > 0 && left+mark.getWidth() <= width )
 		skip += left*bytesperpixel;
 
 	return skip;
 }
 
+/**
+ * Get the area a mark covers in pixels
+ *
+ * @param type - type of the mark
+ * @param left - left margin of mark
+ * @param top - top margin of mark
+ * @param x - left edge of the area
+ * @param y - top edge of the area
+ * @param w - width of the area
+ * @param h - height of the area
+ */
+void Render::getMarkArea( MarkType type, int left, int top, int &x, int &y,
+	int &w, int &h ) const
+{
+	Render::Mark mark = getMark( type );
+	int bytesperpixel = (bytesperline-padding)/width;
+	unsigned int offset = getOffset( left, top, mark, bytesperpixel );
+
+	x = (offset%bytesperline)/bytesperpixel;
+	y = offset/bytesperline;
+	w = mark.getWidth();
+	h = mark.getHeight();
+}
+
+/**
+ * Move both pointers to the first row to render and return the
+ * number of rows left to render
+ *
+ * @param dest - destination pixels
+ * @param src - source pixels (in rgba format !)
+ * @param first - first row to render
+ * @param count - number of rows to render, negative for all
+ */
+int Render::getRows( unsigned char *&dest, unsigned char *&src, int first,
+	int count ) const
+{
+	if( first < 0 )
+		first = 0;
+
+	if( count < 0 ||
+		first+count > height )
+		count = height-first;
+
+	if( count < 1 )
+		return 0;
+
+	dest += first*bytesperline;
+	src += first*width*4;
+
+	return count;
+}
+
 /**
  * Initialize object
  *
@@ -172,10 +229,13 @@ Render16::Render16( int width, int height )
  *
  * @param dest - destination pixels
  * @param src - source pixels (in rgba format !)
+ * @param first - first row to render (optional)
+ * @param count - number of rows to render, negative for all (optional)
  */
-void Render16::opaque( unsigned char *dest, unsigned char *src )
+void Render16::opaque( unsigned char *dest, unsigned char *src,
+	int first, int count )
 {
-	for( int y = height; y--; dest += padding )
+	for( int y = getRows( dest, src, first, count ); y--; dest += padding )
 		for( int x = width; x--; )
 			switch( *((int *) src) & 0xff000000 )
 			{
@@ -242,13 +302,15 @@ void Render16::opaque( unsigned char *dest, unsigned char *src )
  * @param dest - destination pixels
  * @param src - source pixels (in rgba format !)
  * @param transparency - global transparency
+ * @param first - first row to render (optional)
+ * @param count - number of rows to render, negative for all (optional)
  */
 void Render16::ghosted( unsigned char *dest, unsigned char *src, 
-	unsigned char transparency )
+	unsigned char transparency, int first, int count )
 {
 	double alphamax = ((double) 255*((double) 255/(double) transparency));
 
-	for( int y = height; y--; dest += padding )
+	for( int y = getRows( dest, src, first, count ); y--; dest += padding )
 		for( int x = width; x--; )
 			if( !(*((int *) src) & 0xff000000) )
 			{
@@ -315,7 +377,7 @@ void Render16::activeMark( unsigned char *dest, MarkType type,
 	dest += getOffset( left, top, mark, 2 );
 
 	short *p = (short *) dest;
-	int skip = width-mark.getWidth();
+	int skip = (bytesperline>>1)-mark.getWidth();
 	const char *src = mark.getPixels();
 
 	for( int y = mark.getHeight(); y--; p += skip )
@@ -340,10 +402,13 @@ Render24::Render24( int width, int height )
  *
  * @param dest - destination pixels
  * @param src - source pixels (in rgba format !)
+ * @param first - first row to render (optional)
+ * @param count - number of rows to render, negative for all (optional)
  */
-void Render24::opaque( unsigned char *dest, unsigned char *src )
+void Render24::opaque( unsigned char *dest, unsigned char *src,
+	int first, int count )
 {
-	for( int y = height; y--; dest += padding )
+	for( int y = getRows( dest, src, first, count ); y--; dest += padding )
 		for( int x = width; x--; )
 			switch( *((int *) src) & 0xff000000 )
 			{
@@ -389,13 +454,15 @@ void Render24::opaque( unsigned char *dest, unsigned char *src )
  * @param dest - destination pixels
  * @param src - source pixels (in rgba format !)
  * @param transparency - global transparency
+ * @param first - first row to render (optional)
+ * @param count - number of rows to render, negative for all (optional)
  */
 void Render24::ghosted( unsigned char *dest, unsigned char *src, 
-	unsigned char transparency )
+	unsigned char transparency, int first, int count )
 {
 	double alphamax = ((double) 255*((double) 255/(double) transparency));
 
-	for( int y = height; y--; dest += padding )
+	for( int y = getRows( dest, src, first, count ); y--; dest += padding )
 		for( int x = width; x--; )
 			if( !(*((int *) src) & 0xff000000) )
 			{
@@ -460,6 +527,8 @@ void Render24::activeMark( unsigned char *dest, MarkType type,
 				*(dest++) ^= 0xff;
 				*(dest++) ^= 0xff;
 			}
+			else
+				dest += 3;
 }
 
 /**
@@ -478,10 +547,13 @@ Render32::Render32( int width, int height )
  *
  * @param dest - destination pixels
  * @param src - source pixels (in rgba format !)
+ * @param first - first row to render (optional)
+ * @param count - number of rows to render, negative for all (optional)
  */
-void Render32::opaque( unsigned char *dest, unsigned char *src )
+void Render32::opaque( unsigned char *dest, unsigned char *src,
+	int first, int count )
 {
-	for( int p = pixels; p--; )
+	for( int p = getRows( dest, src, first, count )*width; p--; )
 		switch( *((int *) src) & 0xff000000 )
 		{
 			case 0:
@@ -526,13 +598,15 @@ void Render32::opaque( unsigned char *dest, unsigned char *src )
  * @param dest - destination pixels
  * @param src - source pixels (in rgba format !)
  * @param transparency - global transparency
+ * @param first - first row to render (optional)
+ * @param count - number of rows to render, negative for all (optional)
  */
 void Render32::ghosted( unsigned char *dest, unsigned char *src, 
-	unsigned char transparency )
+	unsigned char transparency, int first, int count )
 {
 	double alphamax = ((double) 255*((double) 255/(double) transparency));
 
-	for( int p = pixels; p--; )
+	for( int p = getRows( dest, src, first, count )*width; p--; )
 		if( !(*((int *) src) & 0xff000000) )
 		{
 			src += 4;
@@ -595,3 +669,107 @@ void Render32::activeMark( unsigned char *dest, MarkType type,
 			if( *(src++) )
 				*p ^= 0xffffff;
 }
+
+/**
+ * Initialize object
+ *
+ * @param width - width of the image in pixels
+ * @param height - height of the image in pixels
+ */
+RenderARGB::RenderARGB( int width, int height )
+{
+	initialize( 32, width, height );
+}
+
+/**
+ * Put a rgba image over a premultiplied 32 bit pixmap
+ *
+ * @param dest - destination pixels
+ * @param src - source pixels (in rgba format !)
+ * @param first - first row to render (optional)
+ * @param count - number of rows to render, negative for all (optional)
+ */
+void RenderARGB::opaque( unsigned char *dest, unsigned char *src,
+	int first, int count )
+{
+	for( int p = getRows( dest, src, first, count )*width; p--;
+		src += 4, dest += 4 )
+	{
+		int alpha = src[3];
+
+		if( !alpha )
+			continue;
+
+		if( alpha == 0xff )
+		{
+			*((int *) dest) = *((int *) src);
+			continue;
+		}
+
+		int inverse = 0xff-alpha;
+
+		dest[0] = (src[0]*alpha+dest[0]*inverse+127)/255;
+		dest[1] = (src[1]*alpha+dest[1]*inverse+127)/255;
+		dest[2] = (src[2]*alpha+dest[2]*inverse+127)/255;
+		dest[3] = alpha+(dest[3]*inverse+127)/255;
+	}
+}
+
+/**
+ * Put a rgba image greyed over a premultiplied 32 bit pixmap
+ *
+ * @param dest - destination pixels
+ * @param src - source pixels (in rgba format !)
+ * @param transparency - global transparency
+ * @param first - first row to render (optional)
+ * @param count - number of rows to render, negative for all (optional)
+ */
+void RenderARGB::ghosted( unsigned char *dest, unsigned char *src, 
+	unsigned char transparency, int first, int count )
+{
+	for( int p = getRows( dest, src, first, count )*width; p--;
+		src += 4, dest += 4 )
+	{
+		int alpha = src[3]*transparency/255;
+
+		if( !alpha )
+			continue;
+
+		int grey = (src[0]+src[1]+src[2])/3*alpha;
+		int inverse = 0xff-alpha;
+
+		dest[0] = (grey+dest[0]*inverse+127)/255;
+		dest[1] = (grey+dest[1]*inverse+127)/255;
+		dest[2] = (grey+dest[2]*inverse+127)/255;
+		dest[3] = alpha+(dest[3]*inverse+127)/255;
+	}
+}
+
+/**
+ * Render active-mark into a premultiplied 32 bit surface, pixels
+ * that are not opaque become opaque white since there is nothing to
+ * invert
+ *
+ * @param dest - destination pixels
+ * @param type - type of the mark (optional)
+ * @param left - left margin of mark (optional)
+ * @param top - top margin of mark (optional)
+ */
+void RenderARGB::activeMark( unsigned char *dest, MarkType type, 
+	int left, int top )
+{
+	Render::Mark mark = getMark( type );
+
+	dest += getOffset( left, top, mark, 4 );
+
+	unsigned int *p = (unsigned int *) dest;
+	int skip = width-mark.getWidth();
+	const char *src = mark.getPixels();
+
+	for( int y = mark.getHeight(); y--; p += skip )
+		for( int x = mark.getWidth(); x--; p++ )
+			if( *(src++) )
+				*p = (*p & 0xff000000) == 0xff000000 ?
+					*p ^ 0xffffff :
+					0xffffffff;
+}
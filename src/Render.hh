@@ -49,7 +49,7 @@ namespace bbdock
 	 * the right object
 	 *
 	 * @author mf@markusfisch.de
-	 * @version 0.1.4
+	 * @version 0.1.6
 	 */
 	class Render
 	{
@@ -63,16 +63,21 @@ namespace bbdock
 			};
 
 			inline const int &getSize() const { return size; }
+			inline const int &getBytesPerLine() const {
+				return bytesperline; }
 
 			Render() {}
 			virtual ~Render() {}
 			Render &operator=( Render & ) {}
-			static Render *getInstance( int, int, int );
-			virtual void opaque( unsigned char *, unsigned char * ) {}
+			static Render *getInstance( int, int, int, bool = false );
+			virtual void opaque( unsigned char *, unsigned char *,
+				int = 0, int = -1 ) {}
 			virtual void ghosted( unsigned char *, unsigned char *, 
-				unsigned char ) {}
+				unsigned char, int = 0, int = -1 ) {}
 			virtual void activeMark( unsigned char *, MarkType = PlayMark,
 				int = 0, int = 0 ) {}
+			virtual void getMarkArea( MarkType, int, int, int &, int &,
+				int &, int & ) const;
 
 		protected:
 			/**
@@ -112,22 +117,25 @@ namespace bbdock
 			virtual const Render::Mark &getMark( MarkType ) const;
 			virtual unsigned int getOffset( int, int, Render::Mark &, 
 				int ) const;
+			virtual int getRows( unsigned char *&, unsigned char *&,
+				int, int ) const;
 	};
 
 	/**
 	 * Render16 knows how to draw on surfaces of 16 bits color depth
 	 *
 	 * @author mf@markusfisch.de
-	 * @version 0.1.3
+	 * @version 0.1.4
 	 */
 	class Render16 : Render
 	{
 		public:
 			Render16( int, int );
 			virtual ~Render16() {}
-			virtual void opaque( unsigned char *, unsigned char * );
+			virtual void opaque( unsigned char *, unsigned char *,
+				int = 0, int = -1 );
 			virtual void ghosted( unsigned char *, unsigned char *, 
-				unsigned char );
+				unsigned char, int = 0, int = -1 );
 			virtual void activeMark( unsigned char *, MarkType = PlayMark,
 				int = 0, int = 0 );
 	};
@@ -136,16 +144,17 @@ namespace bbdock
 	 * Render24 knows how to draw on surfaces of 24 bits color depth
 	 *
 	 * @author mf@markusfisch.de
-	 * @version 0.1.3
+	 * @version 0.1.4
 	 */
 	class Render24 : Render
 	{
 		public:
 			Render24( int, int );
 			virtual ~Render24() {}
-			virtual void opaque( unsigned char *, unsigned char * );
+			virtual void opaque( unsigned char *, unsigned char *,
+				int = 0, int = -1 );
 			virtual void ghosted( unsigned char *, unsigned char *, 
-				unsigned char );
+				unsigned char, int = 0, int = -1 );
 			virtual void activeMark( unsigned char *, MarkType = PlayMark,
 				int = 0, int = 0 );
 	};
@@ -154,16 +163,37 @@ namespace bbdock
 	 * Render32 knows how to draw on surfaces of 32 bits color depth
 	 *
 	 * @author mf@markusfisch.de
-	 * @version 0.1.3
+	 * @version 0.1.4
 	 */
 	class Render32 : Render
 	{
 		public:
 			Render32( int, int );
 			virtual ~Render32() {}
-			virtual void opaque( unsigned char *, unsigned char * );
+			virtual void opaque( unsigned char *, unsigned char *,
+				int = 0, int = -1 );
+			virtual void ghosted( unsigned char *, unsigned char *, 
+				unsigned char, int = 0, int = -1 );
+			virtual void activeMark( unsigned char *, MarkType = PlayMark,
+				int = 0, int = 0 );
+	};
+
+	/**
+	 * RenderARGB draws premultiplied pixels with an alpha channel on
+	 * surfaces of a 32 bit visual so the compositor can blend them
+	 *
+	 * @author mf@markusfisch.de
+	 * @version 0.0.2
+	 */
+	class RenderARGB : Render
+	{
+		public:
+			RenderARGB( int, int );
+			virtual ~RenderARGB() {}
+			virtual void opaque( unsigned char *, unsigned char *,
+				int = 0, int = -1 );
 			virtual void ghosted( unsigned char *, unsigned char *, 
-				unsigned char );
+				unsigned char, int = 0, int = -1 );
 			virtual void activeMark( unsigned char *, MarkType = PlayMark,
 				int = 0, int = 0 );
 	};
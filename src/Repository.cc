@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2006 Markus Fisch
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Markus Fisch nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <string>
+#include <map>
+
+#include "Repository.hh"
+
+using namespace std;
+using namespace bbdock;
+
+map<string, Repository::Entry> Repository::entries;
+unsigned long Repository::serial = 0;
+
+/**
+ * Return a new reference to the image of a file if it is known and
+ * up to date, 0 otherwise
+ *
+ * @param file - image file
+ * @param maxwidth - maximum width the image was fitted to
+ * @param maxheight - maximum height the image was fitted to
+ * @param scale - scale factor the image was scaled by
+ */
+Image *Repository::get( const string &file, int maxwidth, int maxheight, 
+	float scale )
+{
+	map<string, Entry>::iterator it;
+	struct stat st;
+
+	if( (it = entries.find( getKey( file, maxwidth, maxheight, 
+			scale ) )) == entries.end() ||
+		stat( file.c_str(), &st ) < 0 ||
+		!isCurrent( it->second, st ) )
+		return 0;
+
+	it->second.used = ++serial;
+
+	return it->second.image->acquire();
+}
+
+/**
+ * Add a decoded image and return a reference to the shared image,
+ * takes over the reference of the caller; if a copy decoded from the
+ * same state of the file is already known the given image gets
+ * dropped
+ *
+ * @param file - image file
+ * @param maxwidth - maximum width the image was fitted to
+ * @param maxheight - maximum height the image was fitted to
+ * @param scale - scale factor the image was scaled by
+ * @param st - status of the file when it was decoded
+ * @param image - decoded image
+ */
+Image *Repository::put( const string &file, int maxwidth, int maxheight, 
+	float scale, const struct stat &st, Image *image )
+{
+	Entry &e = entries[getKey( file, maxwidth, maxheight, scale )];
+
+	if( e.image &&
+		isCurrent( e, st ) )
+	{
+		image->release();
+		e.used = ++serial;
+
+		return e.image->acquire();
+	}
+
+	// images still in use stay alive without the repository
+	if( e.image )
+		e.image->release();
+
+	e.file = file;
+	e.image = image->acquire();
+	e.mtime = st.st_mtim;
+	e.ctime = st.st_ctim;
+	e.size = st.st_size;
+	e.inode = st.st_ino;
+	e.used = ++serial;
+
+	trim();
+
+	return image;
+}
+
+/**
+ * Drop all entries of a file
+ *
+ * @param file - image file
+ */
+void Repository::forget( const string &file )
+{
+	for( map<string, Entry>::iterator it = entries.begin(); 
+		it != entries.end(); )
+		if( it->second.file == file )
+		{
+			it->second.image->release();
+			entries.erase( it++ );
+		}
+		else
+			++it;
+}
+
+/**
+ * Drop least recently used images nobody else refers to
+ */
+void Repository::trim()
+{
+	for( ;; )
+	{
+		map<string, Entry>::iterator it = entries.begin();
+		map<string, Entry>::iterator end = entries.end();
+		map<string, Entry>::iterator oldest = end;
+		int unused = 0;
+
+		for( ; it != end; ++it )
+			if( it->second.image->getReferences() < 2 )
+			{
+				if( oldest == end ||
+					it->second.used < oldest->second.used )
+					oldest = it;
+
+				unused++;
+			}
+
+		if( unused <= MaxUnused )
+			break;
+
+		oldest->second.image->release();
+		entries.erase( oldest );
+	}
+}
+
+/**
+ * Returns true if an entry was decoded from a file with the given
+ * status
+ *
+ * @param e - entry
+ * @param st - status of the file
+ */
+bool Repository::isCurrent( const Entry &e, const struct stat &st )
+{
+	return e.mtime.tv_sec == st.st_mtim.tv_sec &&
+		e.mtime.tv_nsec == st.st_mtim.tv_nsec &&
+		e.ctime.tv_sec == st.st_ctim.tv_sec &&
+		e.ctime.tv_nsec == st.st_ctim.tv_nsec &&
+		e.size == st.st_size &&
+		e.inode == st.st_ino;
+}
+
+/**
+ * Return key of the entry of a file fitted to a size and scale factor
+ *
+ * @param file - image file
+ * @param maxwidth - maximum width
+ * @param maxheight - maximum height
+ * @param scale - scale factor
+ */
+string Repository::getKey( const string &file, int maxwidth, 
+	int maxheight, float scale )
+{
+	char buf[64];
+
+	snprintf( buf, sizeof( buf ), "\n%dx%d-%d", maxwidth, maxheight,
+		(int) (scale*100+.5f) );
+
+	return file+buf;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2006 Markus Fisch
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Markus Fisch nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef bbdock_Repository_hh
+#define bbdock_Repository_hh
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string>
+#include <map>
+
+#include "Image.hh"
+
+namespace bbdock
+{
+	/**
+	 * Repository shares decoded images among all slots of a process,
+	 * so there is only one copy of each image file in memory for
+	 * every size and scale factor it has been fitted to; a few
+	 * unused images are kept around to make switching between a set
+	 * of icons cheap; an image is known as long as the status of its
+	 * file didn't change since it was decoded; must only be used from
+	 * the main thread
+	 *
+	 * @author mf@markusfisch.de
+	 * @version 0.0.3
+	 */
+	class Repository
+	{
+		public:
+			static Image *get( const std::string &, int, int, float );
+			static Image *put( const std::string &, int, int, float,
+				const struct stat &, Image * );
+			static void forget( const std::string & );
+
+			enum
+			{
+				MaxUnused = 16
+			};
+
+		private:
+			/**
+			 * A repository entry
+			 */
+			class Entry
+			{
+				public:
+					std::string file;
+					Image *image;
+					struct timespec mtime;
+					struct timespec ctime;
+					off_t size;
+					ino_t inode;
+					unsigned long used;
+
+					Entry() :
+						image( 0 ),
+						size( 0 ),
+						inode( 0 ),
+						used( 0 )
+					{
+						mtime.tv_sec = ctime.tv_sec = 0;
+						mtime.tv_nsec = ctime.tv_nsec = 0;
+					}
+			};
+
+			static std::map<std::string, Entry> entries;
+			static unsigned long serial;
+
+			static void trim();
+			static bool isCurrent( const Entry &, const struct stat & );
+			static std::string getKey( const std::string &, int, int, 
+				float );
+	};
+}
+
+#endif
@@ -27,6 +27,7 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 #include <sys/types.h>
+#include <sys/time.h>
 #include <signal.h>
 #include <sys/wait.h>
 #include <stdlib.h>
@@ -34,8 +35,12 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <spawn.h>
 #include <iostream>
+#include <algorithm>
 #include <string>
+#include <vector>
+#include <map>
 
 #include "Slot.hh"
 
@@ -45,32 +50,51 @@ using namespace std;
 using namespace bbdock;
 
 const double Slot::fadestep = 1.05;
+map<string, string> Slot::paths;
 
 /**
  * Initialize object
  *
  * @param d - Dock object
- * @param i - Icon object
- * @param n - next Slot in chain
+ * @param i - Icon object, the slot takes ownership of it
+ * @param n - number of slot
  */
-Slot::Slot( Dock &d, Icon &i, Slot *n ) :
+Slot::Slot( Dock &d, Icon &i, int n ) :
 	dock( &d ),
 	icon( &i ),
-	next( n ),
+	id( n ),
 	render( 0 ),
-	normalicon( 0 ),
 	surface( 0 ),
+	normalicon( 0 ),
+	image( 0 ),
 	background( 0 ),
-	invalid( false ),
+	left( 0 ),
+	top( 0 ),
+	width( 0 ),
+	height( 0 ),
 	visibility( VisibilityUnobscured ),
+	parent( 0 ),
+	x( 0 ),
+	y( 0 ),
+	invalid( false ),
+	damaged( false ),
+	dirtyleft( 0 ),
+	dirtytop( 0 ),
+	dirtyright( 0 ),
+	dirtybottom( 0 ),
 	wm( d.getDisplay() ),
 	pid( 0 ),
-	fading( Complete )
+	fading( Complete ),
+	renders( 0 ),
+	draws( 0 ),
+	clicked( 0 ),
+	stage( Stages ),
+	created( Histogram::now() ),
+	prelaunching( i.getPrelaunch() > -1 && i.isExclusive() ),
+	hiding( false ),
+	launched( 0 )
 {
-	loadIcon();
-
 	Window root;
-	Window dummy;
 
 	root = RootWindow( dock->getDisplay(), dock->getScreen() );
 
@@ -89,16 +113,28 @@ Slot::Slot( Dock &d, Icon &i, Slot *n ) :
 	    XSetWindowAttributes xswat;
 		unsigned long vmask;
 
-		xswat.background_pixmap = ParentRelative;
-		vmask = CWBackPixmap;
+		if( dock->hasAlpha() )
+		{
+			// a window of another depth than its parent needs its own
+			// colormap and border
+			xswat.background_pixel = 0;
+			xswat.border_pixel = 0;
+			xswat.colormap = dock->getColormap();
+			vmask = CWBackPixel | CWBorderPixel | CWColormap;
+		}
+		else
+		{
+			xswat.background_pixmap = ParentRelative;
+			vmask = CWBackPixmap;
+		}
 
 		window = XCreateWindow( dock->getDisplay(), root,
 			sh.x, sh.y,
 			sh.width, sh.height,
 			0,
-			CopyFromParent,
+			dock->getDepth(),
 			InputOutput,
-			CopyFromParent,
+			dock->getVisual(),
 			vmask, &xswat );
 
 		sh.flags = USSize | USPosition;
@@ -145,6 +181,11 @@ Slot::~Slot()
 {
 	destorySurface();
 	destroyIcon();
+
+	XDestroyWindow( dock->getDisplay(), window );
+	XDestroyWindow( dock->getDisplay(), dummy );
+
+	delete icon;
 }
 
 /**
@@ -154,41 +195,194 @@ Slot::~Slot()
  */
 void Slot::draw( bool refresh )
 {
-	if( refresh || invalid )
+	// nothing to show until the image got decoded
+	if( !surface )
+		return;
+
+	// backgrounds of all slots are captured at once by the dock;
+	// there is nothing to capture when the compositor blends
+	if( invalid &&
+		!dock->hasAlpha() )
 	{
-		// restore background
-		if( invalid )
-			getBackground();
-		else
-			memcpy( image, background, render->getSize() );
+		dock->invalidate();
+		return;
+	}
+
+	paint( refresh, 0, 0, width, height );
+}
+
+/**
+ * Add a rectangle to the region that needs to be drawn again, the
+ * rectangle is given in coordinates of the icon
+ *
+ * @param x - left edge
+ * @param y - top edge
+ * @param w - width
+ * @param h - height
+ */
+void Slot::damage( int x, int y, int w, int h )
+{
+	int r = std::min( x+w, width );
+	int b = std::min( y+h, height );
+
+	x = std::max( x, 0 );
+	y = std::max( y, 0 );
+
+	// parts of the window that the icon doesn't cover are drawn
+	// by the server
+	if( r <= x ||
+		b <= y )
+		return;
+
+	if( !damaged )
+	{
+		damaged = true;
+		dirtyleft = x;
+		dirtytop = y;
+		dirtyright = r;
+		dirtybottom = b;
+		return;
+	}
+
+	dirtyleft = std::min( dirtyleft, x );
+	dirtytop = std::min( dirtytop, y );
+	dirtyright = std::max( dirtyright, r );
+	dirtybottom = std::max( dirtybottom, b );
+}
+
+/**
+ * Display only the damaged region of the icon
+ *
+ * @param refresh - refresh background
+ */
+void Slot::repair( bool refresh )
+{
+	if( !surface ||
+		!damaged )
+		return;
+
+	// a capture paints everything anyway
+	if( invalid &&
+		!dock->hasAlpha() )
+	{
+		dock->invalidate();
+		return;
+	}
+
+	paint( refresh, dirtyleft, dirtytop, dirtyright, dirtybottom );
+}
+
+/**
+ * Mark the area of the active mark as damaged
+ */
+void Slot::damageMark()
+{
+	if( !render )
+		return;
+
+	int x;
+	int y;
+	int w;
+	int h;
+
+	render->getMarkArea( dock->getMarkType(), dock->getMarkLeft(),
+		dock->getMarkTop(), x, y, w, h );
+
+	damage( x, y, w, h );
+}
+
+/**
+ * Render and put a region of the icon
+ *
+ * @param refresh - restore background and render again
+ * @param l - left edge of region
+ * @param t - top edge of region
+ * @param r - right edge of region
+ * @param b - bottom edge of region
+ */
+void Slot::paint( bool refresh, int l, int t, int r, int b )
+{
+	long long start = Histogram::now();
+
+	damaged = false;
+
+	if( refresh )
+	{
+		bool mark = pid && icon->isExclusive();
+
+		// the mark is inverted over what's below, so its rows must be
+		// restored and rendered completely or not at all
+		if( mark )
+		{
+			int x;
+			int y;
+			int w;
+			int h;
+
+			render->getMarkArea( dock->getMarkType(), dock->getMarkLeft(),
+				dock->getMarkTop(), x, y, w, h );
+
+			if( y < b &&
+				y+h > t )
+			{
+				t = std::min( t, y );
+				b = std::min( std::max( b, y+h ), height );
+			}
+			else
+				mark = false;
+		}
+
+		// restore background of whole rows
+		{
+			int offset = t*render->getBytesPerLine();
+
+			memcpy( image+offset, background+offset,
+				(b-t)*render->getBytesPerLine() );
+		}
 
 		// render active mark
-		if( pid && icon->isExclusive() )
+		if( mark )
 			render->activeMark( (unsigned char *) image,
 				dock->getMarkType(), dock->getMarkLeft(), dock->getMarkTop() );
 
 		// render icon
 		if( fading < Complete )
 			render->ghosted( (unsigned char *) image,
-				(unsigned char *) normalicon, fading );
+				(unsigned char *) normalicon->getPixels(), fading, t, b-t );
 		else
 			render->opaque( (unsigned char *) image,
-				(unsigned char *) normalicon );
+				(unsigned char *) normalicon->getPixels(), t, b-t );
+
+		renders++;
 	}
 
-	XPutImage( dock->getDisplay(), window, dock->getGC(), surface, 0, 0,
-		left, top, width, height );
+	draws++;
+	XPutImage( dock->getDisplay(), window, dock->getGC(), surface, l, t,
+		left+l, top+t, r-l, b-t );
+
+	if( dock->isObserved() )
+	{
+		char buf[32];
+
+		snprintf( buf, sizeof( buf ), "%lld", Histogram::now()-start );
+
+		dock->notify( "redraw", id, buf );
+	}
 }
 
 /**
  * Execute command
  *
  * @param arg - command line arguments (optional)
+ * @param t - time of the click in microseconds of Histogram::now() (optional)
  */
-void Slot::exec( char *arg )
+void Slot::exec( char *arg, long long t )
 {
 	if( pid && icon->isExclusive() )
 	{
+		// don't hide a window the user is waiting for
+		hiding = false;
+
 		if( !icon->getTitle().empty() )
 		{
 			vector<string> t = icon->getTitle();
@@ -214,34 +408,23 @@ void Slot::exec( char *arg )
 		icon->getCommand().empty() )
 		return;
 
-	switch( (pid = fork()) )
-	{
-		case -1:
-			throw "Fork failed !";
-			return;
-		case 0:
-			{
-				string cmd = icon->getCommand();
+	clicked = t ? t : Histogram::now();
 
-				if( arg )
-				{
-					cmd += " ";
-					cmd += arg;
-				}
+	if( !launch( arg ) )
+		return;
 
-				char *argv[4];
+	{
+		long long us = Histogram::now()-clicked;
+		char buf[64];
 
-				argv[0] = (char *) "sh";
-				argv[1] = (char *) "-c";
-				argv[2] = (char *) cmd.c_str();
-				argv[3] = 0;
+		latency[Spawned].add( us );
 
-				setsid();
-				execve( "/bin/sh", argv, environ );
+		// windows can only be told apart for exclusive icons
+		stage = icon->isExclusive() ? WindowAppeared : Stages;
 
-				throw "Exec failed !";
-			}
-			return;
+		// report pid and time it took to start the process in µs
+		snprintf( buf, sizeof( buf ), "%d\t%lld", pid, us );
+		dock->notify( "launched", id, buf );
 	}
 
 	// calculate offset for fade-in, this is here and done on every launch
@@ -261,6 +444,168 @@ void Slot::exec( char *arg )
 	draw( true );
 }
 
+/**
+ * Start the command, returns false if that failed
+ *
+ * @param arg - command line arguments (optional)
+ */
+bool Slot::launch( char *arg )
+{
+	const vector<string> &args = icon->getArguments();
+	string cmd = icon->getCommand();
+	int error;
+
+	// windows that exist before the launch can't be the application's
+	launched = 0;
+
+	if( icon->isExclusive() )
+		wm.getClients( clients );
+
+	// simple commands don't need a shell, arguments from a remote
+	// execution are left to the shell though
+	if( !arg &&
+		!args.empty() )
+	{
+		vector<char *> argv;
+
+		for( vector<string>::const_iterator it = args.begin();
+			it != args.end(); ++it )
+			argv.push_back( (char *) it->c_str() );
+
+		argv.push_back( 0 );
+		error = spawn( resolve( args[0] ), &argv[0] );
+
+		// the binary may have moved or been installed since it was
+		// resolved
+		if( error == ENOENT &&
+			paths.erase( args[0] ) )
+			error = spawn( resolve( args[0] ), &argv[0] );
+	}
+	else
+	{
+		char *argv[4];
+
+		if( arg )
+		{
+			cmd += " ";
+			cmd += arg;
+		}
+
+		argv[0] = (char *) "sh";
+		argv[1] = (char *) "-c";
+		argv[2] = (char *) cmd.c_str();
+		argv[3] = 0;
+
+		error = spawn( "/bin/sh", argv );
+	}
+
+	if( error )
+	{
+		stop();
+		pid = 0;
+		cerr << cmd << ": " << strerror( error ) << endl;
+		dock->notify( "failed", id, strerror( error ) );
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Start a process without copying the address space of the dock,
+ * returns 0 on success or an error number
+ *
+ * @param file - path of executable, empty if it wasn't found
+ * @param argv - arguments
+ */
+int Slot::spawn( const string &file, char **argv )
+{
+	if( file.empty() )
+		return ENOENT;
+
+	posix_spawnattr_t attr;
+	sigset_t mask;
+	short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+	int error;
+
+	if( (error = posix_spawnattr_init( &attr )) )
+		return error;
+
+	// the child should not inherit signal settings of the dock
+	sigemptyset( &mask );
+	posix_spawnattr_setsigmask( &attr, &mask );
+	sigaddset( &mask, SIGHUP );
+	sigaddset( &mask, SIGPIPE );
+	sigaddset( &mask, SIGCHLD );
+	posix_spawnattr_setsigdefault( &attr, &mask );
+
+#ifdef POSIX_SPAWN_SETSID
+	// detach from the session of the dock
+	flags |= POSIX_SPAWN_SETSID;
+#endif
+
+	posix_spawnattr_setflags( &attr, flags );
+
+	error = posix_spawn( &pid, file.c_str(), 0, &attr, argv, environ );
+	posix_spawnattr_destroy( &attr );
+
+	return error;
+}
+
+/**
+ * Return path of executable, looks it up in PATH once and remembers
+ * the result; like the shell, names without a slash are never taken
+ * from the current directory unless PATH says so, the path is empty
+ * if there is no such executable
+ *
+ * @param name - name of executable
+ */
+const string &Slot::resolve( const string &name )
+{
+	map<string, string>::iterator it;
+
+	if( (it = paths.find( name )) != paths.end() )
+		return it->second;
+
+	string &path = paths[name];
+	const char *env;
+
+	if( name.find( '/' ) != string::npos )
+	{
+		path = name;
+		return path;
+	}
+
+	// the shell's default
+	if( !(env = getenv( "PATH" )) )
+		env = "/usr/bin:/bin";
+
+	string p = env;
+	string::size_type last = 0;
+	string::size_type next;
+
+	// empty entries stand for the current directory
+	for( ;; last = next+1 )
+	{
+		next = p.find( ':', last );
+
+		string dir = p.substr( last, 
+			next == string::npos ? string::npos : next-last );
+		string candidate = (dir.empty() ? "." : dir)+"/"+name;
+
+		if( !access( candidate.c_str(), X_OK ) )
+		{
+			path = candidate;
+			break;
+		}
+
+		if( next == string::npos )
+			break;
+	}
+
+	return path;
+}
+
 /**
  * Try to iconify the corresponding instance
  */
@@ -355,6 +700,9 @@ void Slot::closeApplication()
  */
 void Slot::tick()
 {
+	if( prelaunching )
+		prelaunch();
+
 	if( !pid )
 		return;
 
@@ -362,10 +710,28 @@ void Slot::tick()
 
 	if( waitpid( pid, &status, WNOHANG | WUNTRACED ) == pid )
 	{
+		char buf[32];
+
+		snprintf( buf, sizeof( buf ), "%d\t%d", pid, 
+			WIFEXITED( status ) ? WEXITSTATUS( status ) : -1 );
+		dock->notify( "exited", id, buf );
+
+		// only the mark goes away if the icon has faded in already
+		bool faded = fading == Complete;
+
 		pid = 0;
 		fading = Complete;
+		stop();
+		hiding = false;
+
+		if( faded )
+		{
+			damageMark();
+			repair( true );
+		}
+		else
+			draw( true );
 
-		draw( true );
 		return;
 	}
 
@@ -388,9 +754,8 @@ void Slot::tick()
 void Slot::setIcon( const char *filename )
 {
 	icon->setImage( filename );
-	loadIcon();
-	invalidate();
-	draw( true );
+
+	dock->notify( "icon", id, icon->getImage() );
 }
 
 /**
@@ -398,9 +763,17 @@ void Slot::setIcon( const char *filename )
  */
 const bool Slot::hasFocus()
 {
-	Window w;
+	return hasFocus( wm.getActiveWindow() );
+}
 
-	if( !(w = wm.getActiveWindow()) )
+/**
+ * Returns true if the given active window belongs to this slot
+ *
+ * @param w - active window
+ */
+const bool Slot::hasFocus( Window w )
+{
+	if( !w )
 		return false;
 
 	vector<string> t = icon->getTitle();
@@ -416,89 +789,233 @@ const bool Slot::hasFocus()
 }
 
 /**
- * Load PNG icon
+ * Append a line describing the state of this slot, fields are
+ * separated by tabs: id, pid, state, fading, bound windows, number of
+ * renders, number of draws and command
+ *
+ * @param s - string to append to
  */
-void Slot::loadIcon()
+void Slot::getState( string &s )
 {
-	png_bytep *rowPointers;
+	const char *state = "idle";
 
-	destroyIcon();
-	width = height = 0;
+	if( pid )
+		state = (fading < Complete ? "fading" : "running");
 
-	png_structp png = 0;
-	png_infop info = 0;
-	FILE *fp = 0;
+	char buf[128];
 
-	if( !(png = png_create_read_struct( PNG_LIBPNG_VER_STRING,
-		0, 0, 0 )) )
-		throw "PNG library error !";
+	snprintf( buf, sizeof( buf ), "slot\t%d\t%d\t%s\t%d\t",
+		id, pid, state, fading );
+	s += buf;
 
-	try
+	// windows are only bound to running exclusive slots
+	if( pid && icon->isExclusive() )
 	{
-		if( !(info = png_create_info_struct( png )) ||
-			setjmp( png_jmpbuf( png ) ) ||
-			!(fp = fopen( icon->getImage().c_str(), "rb" )) )
-			throw 0;
-
-		png_init_io( png, fp );
-		png_set_sig_bytes( png, 0 );
-		png_read_png( png, info,
-			PNG_TRANSFORM_IDENTITY |
-			PNG_TRANSFORM_EXPAND |
-			PNG_TRANSFORM_BGR,
-			0 );
-
-		width = png_get_image_width( png, info );
-		height = png_get_image_height( png, info );
-
-		if( !png_get_valid( png, info, PNG_INFO_IDAT ) ||
-			!(normalicon = new int[width*height]) )
-			throw 0;
-
-		rowPointers = png_get_rows( png, info );
-
-		for( int y = 0, *src, *dest = normalicon;
-			y < height && (src = (int *) rowPointers[y]);
-			y++, dest += width )
-			memcpy( dest, src, width<<2 );
-
-		// convert grayscale image to rgb
-		if( png_get_color_type(png, info) == PNG_COLOR_TYPE_GRAY_ALPHA )
-			for( int y = height, *line = normalicon;
-				--y; line += width )
-			{
-				unsigned char *dest = (unsigned char *) line+(width<<2);
-				unsigned char *src = (unsigned char *) line+(width<<1);
-
-				for( int x = width; --x; )
-				{
-					*(--dest) = *(--src);
-					*(--dest) = *(--src);
-					*(--dest) = *src;
-					*(--dest) = *src;
-				}
-			}
+		vector<string> t = icon->getTitle();
+		vector<string>::iterator it = t.begin();
+		vector<string>::iterator end = t.end();
+		int n = 0;
+
+		for( ; it != end; ++it )
+		{
+			Window w;
+
+			if( !(w = wm.getWindowFromName( *it,
+				dock->getCaseSensitive() )) )
+				continue;
+
+			snprintf( buf, sizeof( buf ), "%s0x%lx", (n++ ? "," : ""), w );
+			s += buf;
+		}
 	}
-	catch( int )
+
+	snprintf( buf, sizeof( buf ), "\t%lu\t%lu\t", renders, draws );
+	s += buf;
+	s += icon->getCommand();
+	s += "\n";
+}
+
+/**
+ * Launch the application in the background once the delay after the
+ * creation of this slot has passed, its window gets iconified as soon
+ * as it appears
+ */
+void Slot::prelaunch()
+{
+	long long now = Histogram::now();
+
+	// the icon may have been replaced in the meantime
+	if( pid ||
+		icon->getPrelaunch() < 0 ||
+		!icon->isExclusive() )
 	{
-		// when failed do nothing, first the file needs to be closed
+		prelaunching = false;
+		return;
 	}
 
-	// free possibly allocated resources
-	if( fp )
-		fclose( fp );
+	if( now-created < (long long) icon->getPrelaunch()*1000000 )
+		return;
 
-	png_destroy_read_struct( &png, &info, (png_infopp) 0 );
+	prelaunching = false;
 
-	if( !normalicon || !width || !height )
-		throw "Invalid image file !";
+	if( !launch() )
+		return;
+
+	clicked = now;
+	stage = WindowAppeared;
+	hiding = true;
 
-	if( (left = (dock->getSlotWidth()-width)>>1) < 0 ||
-		(top = (dock->getSlotHeight()-height)>>1) < 0 )
-		throw "Image is too big !";
+	char buf[32];
 
-	// (re-)create surface for this image size
-	createSurface();
+	snprintf( buf, sizeof( buf ), "%d", pid );
+	dock->notify( "prelaunched", id, buf );
+
+	// a prelaunched application doesn't fade in
+	damageMark();
+	repair( true );
+}
+
+/**
+ * Check if the window of a launched application has appeared or has
+ * become active, gives up after some time; only windows that didn't
+ * exist at launch count, must be called when the client list or the
+ * active window changed
+ *
+ * @param active - active window
+ */
+void Slot::track( Window active )
+{
+	if( stage >= Stages )
+		return;
+
+	long long us = Histogram::now()-clicked;
+
+	if( us > MaxTracking )
+	{
+		stop();
+		return;
+	}
+
+	if( stage == WindowAppeared )
+	{
+		for( ;; )
+		{
+			if( !(launched = wm.getNewWindow( icon->getTitle(), clients,
+				dock->getCaseSensitive() )) )
+				return;
+
+			pid_t owner = wm.getWindowPid( launched );
+
+			if( !owner ||
+				owner == pid )
+				break;
+
+			// a new window of another process just happens to match,
+			// it must not be iconified and is ignored from now on
+			clients.insert( lower_bound( clients.begin(), 
+				clients.end(), launched ), launched );
+		}
+
+		// prelaunched applications wait iconified for a click
+		if( hiding )
+		{
+			XIconifyWindow( dock->getDisplay(), launched, 
+				dock->getScreen() );
+			hiding = false;
+			stop();
+			return;
+		}
+
+		latency[stage++].add( us );
+	}
+
+	if( stage == WindowActivated &&
+		active &&
+		active == launched )
+	{
+		latency[stage++].add( us );
+		stop();
+	}
+}
+
+/**
+ * Stop tracking a launched application
+ */
+void Slot::stop()
+{
+	stage = Stages;
+
+	// free the snapshot
+	vector<Window>().swap( clients );
+}
+
+/**
+ * Append a line for every stage of a launch with the latencies
+ * measured so far, fields are separated by tabs: id, stage and the
+ * fields of the histogram
+ *
+ * @param s - string to append to
+ */
+void Slot::getStats( string &s )
+{
+	static const char *names[Stages] = { "spawned", "window", "active" };
+	char buf[64];
+
+	for( int n = 0; n < Stages; ++n )
+	{
+		snprintf( buf, sizeof( buf ), "stats\t%d\t%s\t", id, names[n] );
+		s += buf;
+		latency[n].get( s );
+		s += "\n";
+	}
+}
+
+/**
+ * Replace the Icon object, the slot takes ownership of it; the image
+ * is not loaded
+ *
+ * @param i - Icon object
+ */
+void Slot::replace( Icon *i )
+{
+	if( i == icon )
+		return;
+
+	delete icon;
+	icon = i;
+
+	// the active mark depends on exclusiveness
+	damageMark();
+	repair( true );
+}
+
+/**
+ * Show a decoded image, the slot takes over the reference of the
+ * caller
+ *
+ * @param i - Image object
+ */
+void Slot::setImage( Image *i )
+{
+	destroyIcon();
+
+	// the surface stays if the size doesn't change
+	bool resize = !surface ||
+		width != i->getWidth() ||
+		height != i->getHeight();
+
+	// images have been scaled to fit the slot when they were loaded
+	normalicon = i;
+	width = i->getWidth();
+	height = i->getHeight();
+	left = (dock->getSlotWidth()-width)>>1;
+	top = (dock->getSlotHeight()-height)>>1;
+
+	if( resize )
+		createSurface();
+
+	invalidate();
+	draw( true );
 }
 
 /**
@@ -509,7 +1026,7 @@ void Slot::destroyIcon()
 	if( !normalicon )
 		return;
 
-	delete normalicon;
+	normalicon->release();
 	normalicon = 0;
 }
 
@@ -520,13 +1037,15 @@ void Slot::createSurface()
 {
 	destorySurface();
 
+	Arena &arena = dock->getArena();
+
 	if( !(render = Render::getInstance( dock->getBitsPerPixel(),
-			width, height )) ||
-		!(background = (char *) calloc( render->getSize(), sizeof( char ) )) ||
-		!(image = (char *) calloc( render->getSize(), sizeof( char ) )) ||
+			width, height, dock->hasAlpha() )) ||
+		!(background = arena.allocate( render->getSize() )) ||
+		!(image = arena.allocate( render->getSize() )) ||
 		!(surface = XCreateImage( dock->getDisplay(),
-			DefaultVisual( dock->getDisplay(), dock->getScreen() ),
-			DefaultDepth( dock->getDisplay(), dock->getScreen() ),
+			dock->getVisual(),
+			dock->getDepth(),
 			ZPixmap, 0, image,
 			width, height,
 			32, 0 )) )
@@ -538,74 +1057,69 @@ void Slot::createSurface()
  */
 void Slot::destorySurface()
 {
-	if( !surface )
-		return;
-
-	XDestroyImage( surface );
-	surface = 0;
-	// bitmap memory gets free'd automatically
+	Arena &arena = dock->getArena();
 
-	if( background )
+	if( surface )
 	{
-		free( background );
-		background = 0;
+		// pixels belong to the arena
+		surface->data = 0;
+		XDestroyImage( surface );
+		surface = 0;
 	}
 
 	if( render )
 	{
+		arena.release( background, render->getSize() );
+		arena.release( image, render->getSize() );
 		delete render;
 		render = 0;
 	}
+
+	background = 0;
+	image = 0;
 }
 
 /**
- * Get background image from parent window
+ * Take the background from a capture and draw the icon; the capture
+ * may cover the icon only partly, parts outside are left as they are
+ *
+ * @param capture - captured pixels, may be 0
+ * @param x - left offset of the icon in capture
+ * @param y - top offset of the icon in capture
+ * @param keep - true if the background is valid until invalidated
  */
-void Slot::getBackground()
+void Slot::setBackground( XImage *capture, int x, int y, bool keep )
 {
-	// ensure background is marked as invalid
-	invalid = true;
-
-	Window slit;
-
-	// get parent window
-	{
-		Window root;
-		Window *childs;
-		unsigned int n;
-
- 		XQueryTree( dock->getDisplay(), window, &root, &slit, &childs, &n );
-
-		if( n && childs )
-			XFree( childs );
-	}
-
-	if( !slit )
+	if( !surface )
 		return;
 
-	// check if window is visible on screen since XGetSubImage
-	// fails otherwise
+	if( capture &&
+		capture->bits_per_pixel == surface->bits_per_pixel )
 	{
-		XWindowAttributes wa;
-
-		XGetWindowAttributes( dock->getDisplay(), slit, &wa );
+		int l = x < 0 ? -x : 0;
+		int t = y < 0 ? -y : 0;
+		int r = std::min( width, capture->width-x );
+		int b = std::min( height, capture->height-y );
 
-		if( wa.map_state != IsViewable ||
-			wa.x < 0 ||
-			wa.y < 0 ||
-			wa.x+wa.width > dock->getScreenWidth() ||
-			wa.y+wa.height > dock->getScreenHeight() )
-			return;
-	}
-
-	XClearWindow( dock->getDisplay(), window );
-	XGetSubImage( dock->getDisplay(), window, left, top, width, height,
-		0xffffffff, ZPixmap, surface, 0, 0 );
+		if( r > l &&
+			b > t )
+		{
+			int bytes = surface->bits_per_pixel >> 3;
+			int length = (r-l)*bytes;
+			const char *src = capture->data+(y+t)*capture->bytes_per_line+
+				(x+l)*bytes;
+			char *dest = background+t*surface->bytes_per_line+l*bytes;
 
-	if( visibility == VisibilityUnobscured )
-	{
-		memcpy( background, image, render->getSize() );
+			for( int n = b-t; n--; )
+			{
+				memcpy( dest, src, length );
+				src += capture->bytes_per_line;
+				dest += surface->bytes_per_line;
+			}
 
-		invalid = false;
+			invalid = !keep;
+		}
 	}
+
+	paint( true, 0, 0, width, height );
 }
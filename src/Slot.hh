@@ -31,14 +31,16 @@
 
 #include <unistd.h>
 #include <string>
+#include <vector>
+#include <map>
 
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 
-#include <png.h>
-
 #include "Dock.hh"
+#include "Histogram.hh"
 #include "Icon.hh"
+#include "Image.hh"
 #include "Render.hh"
 #include "WindowManager.hh"
 
@@ -49,55 +51,93 @@ namespace bbdock
 	 * can launch a corresponding application
 	 *
 	 * @author mf@markusfisch.de
-	 * @version 0.2.3
+	 * @version 0.3.5
 	 */
 	class Slot
 	{
 		public:
 			inline const Window &getWindow() const { return window; }
-			inline Slot *getNext() const { return next; }
+			inline const int &getId() const { return id; }
+			inline const int &getPid() const { return pid; }
+			inline const void setId( int i ) { id = i; }
 			inline const char *getIcon() const { 
 				return icon->getImage().c_str(); }
 			inline const char *getCommand() const { 
 				return icon->getCommand().c_str(); }
+			inline const bool hasImage() const { return normalicon != 0; }
 			inline const void setVisibility( int s ) { visibility = s; }
+			inline const int &getVisibility() const { return visibility; }
 			inline const void invalidate() { invalid = true; }
+			inline const bool &isInvalid() const { return invalid; }
+			inline const Window &getParent() const { return parent; }
+			inline const int &getX() const { return x; }
+			inline const int &getY() const { return y; }
+			inline const void setGeometry( Window p, int l, int t ) { 
+				parent = p; x = l; y = t; invalid = true; }
 			inline const int &getLeft() const { return left; }
 			inline const int &getTop() const { return top; }
 			inline const int &getWidth() const { return width; }
 			inline const int &getHeight() const { return height; }
 
-			Slot( Dock &, Icon &, Slot * );
+			Slot( Dock &, Icon &, int );
 			virtual ~Slot();
 			virtual void draw( bool = false );
-			virtual void exec( char * = 0 );
+			virtual void damage( int, int, int, int );
+			virtual void repair( bool = false );
+			virtual void setBackground( XImage *, int, int, bool );
+			virtual void exec( char * = 0, long long = 0 );
 			virtual void iconifyApplication();
 			virtual void lowerApplication();
 			virtual void closeApplication();
 			virtual void tick();
 			virtual void setIcon( const char * );
+			virtual void replace( Icon * );
+			virtual void setImage( Image * );
 			virtual const bool hasFocus();
+			virtual const bool hasFocus( Window );
+			virtual void getState( std::string & );
+			virtual void track( Window );
+			virtual void getStats( std::string & );
 
 		protected:
-			virtual void loadIcon();
+			virtual bool launch( char * = 0 );
+			virtual void prelaunch();
+			virtual void stop();
+			virtual int spawn( const std::string &, char ** );
+			static const std::string &resolve( const std::string & );
 			virtual void destroyIcon();
 			virtual void createSurface();
 			virtual void destorySurface();
-			virtual void getBackground();
+			virtual void damageMark();
+			virtual void paint( bool, int, int, int, int );
 
 		private:
 			enum
 			{
-				Complete = 255
+				Complete = 255,
+				MaxTracking = 60000000 // = one minute
+			};
+
+			/**
+			 * Stages of a launch, the latency of every stage is
+			 * measured from the click
+			 */
+			enum Stage
+			{
+				Spawned,
+				WindowAppeared,
+				WindowActivated,
+				Stages
 			};
 
 			Dock *dock;
 			Icon *icon;
-			Slot *next;
+			int id;
 			Render *render;
 			Window window;
+			Window dummy;
 			XImage *surface;
-			int *normalicon;
+			Image *normalicon;
 			char *image;
 			char *background;
 			int left;
@@ -105,11 +145,30 @@ namespace bbdock
 			int width;
 			int height;
 			int visibility;
+			Window parent;
+			int x;
+			int y;
 			bool invalid;
+			bool damaged;
+			int dirtyleft;
+			int dirtytop;
+			int dirtyright;
+			int dirtybottom;
 			WindowManager wm;
 			int pid;
 			int fading;
+			unsigned long renders;
+			unsigned long draws;
+			Histogram latency[Stages];
+			long long clicked;
+			int stage;
+			long long created;
+			bool prelaunching;
+			bool hiding;
+			std::vector<Window> clients;
+			Window launched;
 			static const double fadestep;
+			static std::map<std::string, std::string> paths;
 	};
 }
 
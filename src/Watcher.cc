@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2006 Markus Fisch
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Markus Fisch nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <sys/types.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#include "Watcher.hh"
+
+using namespace std;
+using namespace bbdock;
+
+/**
+ * Initialize watcher
+ */
+Watcher::Watcher() :
+	fd( -1 )
+{
+#ifdef __linux__
+	fd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+#endif
+}
+
+/**
+ * Stop watching
+ */
+Watcher::~Watcher()
+{
+	if( fd > -1 )
+		close( fd );
+}
+
+/**
+ * Watch a file
+ *
+ * @param file - path and filename of file to watch
+ */
+void Watcher::watch( const string &file )
+{
+	if( fd < 0 ||
+		files.count( file ) )
+		return;
+
+#ifdef __linux__
+	string::size_type p = file.find_last_of( '/' );
+	string dir;
+
+	if( p == string::npos )
+		dir = ".";
+	else if( !p )
+		dir = "/";
+	else
+		dir = file.substr( 0, p );
+
+	int wd;
+
+	if( (wd = inotify_add_watch( fd, dir.c_str(), 
+		IN_CLOSE_WRITE | IN_MOVED_TO )) < 0 )
+		return;
+
+	directories[wd] = (p == string::npos ? "" : file.substr( 0, p+1 ));
+	files.insert( file );
+#endif
+}
+
+/**
+ * Read pending events and collect watched files that did change
+ *
+ * @param changed - receives path and filename of changed files
+ */
+void Watcher::fetch( vector<string> &changed )
+{
+	if( fd < 0 )
+		return;
+
+#ifdef __linux__
+	char buf[4096] 
+		__attribute__ ((aligned(__alignof__(struct inotify_event))));
+	ssize_t n;
+
+	while( (n = read( fd, buf, sizeof( buf ) )) > 0 )
+		for( char *p = buf; p < buf+n; )
+		{
+			struct inotify_event *e = (struct inotify_event *) p;
+			map<int, string>::iterator it;
+
+			p += sizeof( struct inotify_event )+e->len;
+
+			if( !e->len ||
+				(it = directories.find( e->wd )) == directories.end() )
+				continue;
+
+			string file = it->second+e->name;
+
+			if( files.count( file ) )
+				changed.push_back( file );
+		}
+#endif
+}
@@ -32,7 +32,9 @@
 #endif // _GNU_SOURCE
 
 #include <iostream>
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include <string.h>
 
@@ -67,7 +69,7 @@ const bool WindowManager::isValid( Window w ) const
  */
 void WindowManager::activateWindow( Window w ) const
 {
-	WindowManager::Property <unsigned long> p;
+	Property <unsigned long> p;
 
 	// switch to workspace if neccessary
 	if( p.getProperty( display, w, XA_CARDINAL, "_NET_WM_DESKTOP" ) ||
@@ -101,7 +103,7 @@ void WindowManager::closeWindow( Window w ) const
  */
 Window WindowManager::getActiveWindow() const
 {
-	WindowManager::Property <Window> p;
+	Property <Window> p;
 
 	if( !p.getProperty( display, DefaultRootWindow( display ), XA_WINDOW, 
 		"_NET_ACTIVE_WINDOW" ) )
@@ -140,6 +142,76 @@ Window WindowManager::getWindowFromName( string pattern,
 	return 0;	
 }
 
+/**
+ * Return first window whose title matches one of the patterns and
+ * that isn't in a sorted list of known windows; only windows that
+ * are new get inspected
+ *
+ * @param patterns - patterns with wildcards (*?)
+ * @param known - sorted list of windows to ignore
+ * @param casesensitive - true if matching is case sensitive (optional)
+ */
+Window WindowManager::getNewWindow( const vector<string> &patterns,
+	const vector<Window> &known, bool casesensitive )
+{
+	WindowManager::WindowList list = getClientList();
+
+	for( Window w; (w = list.fetch()); )
+	{
+		if( binary_search( known.begin(), known.end(), w ) ||
+			!isValid( w ) )
+			continue;
+
+		string title = getWindowTitle( w );
+		vector<string>::const_iterator it = patterns.begin();
+		vector<string>::const_iterator end = patterns.end();
+
+		for( ; it != end; ++it )
+			if( matchesPattern( title.c_str(), it->c_str(),
+				casesensitive ) )
+			{
+				updateCache( *it, w );
+				return w;
+			}
+	}
+
+	return 0;
+}
+
+/**
+ * Get a sorted list of all application windows
+ *
+ * @param windows - receives the windows
+ */
+void WindowManager::getClients( vector<Window> &windows ) const
+{
+	WindowManager::WindowList list = getClientList();
+
+	windows.clear();
+
+	for( Window w; (w = list.fetch()); )
+		windows.push_back( w );
+
+	sort( windows.begin(), windows.end() );
+}
+
+/**
+ * Return id of the process a window belongs to or 0 if the window
+ * doesn't tell
+ *
+ * @param w - window in question
+ */
+pid_t WindowManager::getWindowPid( Window w ) const
+{
+	Property <unsigned long> p;
+
+	if( !p.getProperty( display, w, XA_CARDINAL, "_NET_WM_PID" ) ||
+		!p.getItems() )
+		return 0;
+
+	return (pid_t) *p.getData();
+}
+
 /**
  * Return title of a window
  *
@@ -147,7 +219,7 @@ Window WindowManager::getWindowFromName( string pattern,
  */
 string WindowManager::getWindowTitle( Window w ) const
 {
-	WindowManager::Property <char> p;
+	Property <char> p;
 	
 	if( !p.getProperty( display, w, XA_STRING, "WM_NAME" ) &&
 		!p.getProperty( display, w, 
@@ -165,8 +237,8 @@ string WindowManager::getWindowTitle( Window w ) const
  */
 WindowManager::WindowList WindowManager::getClientList() const
 {
-	WindowManager::Property <Window> *p = 
-		new WindowManager::Property <Window>();
+	Property <Window> *p = 
+		new Property <Window>();
 
 	if( !p->getProperty( display, root, XA_WINDOW, "_NET_CLIENT_LIST" ) )
 		p->getProperty( display, root, XA_CARDINAL, "_WIN_CLIENT_LIST" );
@@ -29,19 +29,22 @@
 #ifndef bbdock_WindowManager_hh
 #define bbdock_WindowManager_hh
 
+#include <sys/types.h>
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
 
 #include <string>
 #include <vector>
 
+#include "Property.hh"
+
 namespace bbdock
 {
 	/**
 	 * WindowManager knows how to talk to the window manager
 	 *
 	 * @author mf@markusfisch.de
-	 * @version 0.0.3
+	 * @version 0.0.5
 	 */
 	class WindowManager
 	{
@@ -55,68 +58,12 @@ namespace bbdock
 			void closeWindow( Window ) const; 
 			Window getActiveWindow() const;
 			Window getWindowFromName( std::string, bool = false );
+			Window getNewWindow( const std::vector<std::string> &,
+				const std::vector<Window> &, bool = false );
+			void getClients( std::vector<Window> & ) const;
+			pid_t getWindowPid( Window ) const;
 
 		private:
-			/**
-			 * Property object
-			 */
-			template <class T> class Property
-			{
-				public:
-					inline T *getData() const { return data; }
-					inline unsigned long getItems() const { return items; }
-
-					Property() : data( 0 ), items( 0 ) {}
-					bool getProperty( Display *display, Window w, Atom type, 
-						const char *name )
-					{
-						free();
-
-						Atom returnedtype;
-						int format;
-						unsigned long items;
-						unsigned long bytesafter;
-						unsigned char *data;
-
-						if( XGetWindowProperty( display, w, 
-							XInternAtom( display, name, False ), 
-							0, 1024, False, type, &returnedtype, 
-							&format, &items, &bytesafter, 
-							&data ) != Success )
-							return false;
-
-						if( returnedtype != type )
-						{
-							XFree( data );
-							return false;
-						}
-
-						this->data = reinterpret_cast<T *>(data);
-						this->items = items;
-
-						return true;
-					}
-					virtual ~Property()
-					{
-						free();
-					}
-
-				private:
-					T *data;
-					unsigned long items;
-
-					const void free()
-					{
-						if( !data )
-							return;
-
-						XFree( reinterpret_cast<unsigned char *>(data) );
-
-						data = 0;
-						items = 0;
-					}
-			};
-
 			/**
 			 * Iterateable window list
 			 */
@@ -32,9 +32,10 @@
 #include <string.h>
 #include <unistd.h>
 #include <iostream>
-#include <fstream>
 
+#include "Control.hh"
 #include "Dock.hh"
+#include "Icon.hh"
 #include "Render.hh"
 
 using namespace std;
@@ -49,65 +50,12 @@ using namespace bbdock;
  */
 bool add( Dock &dock, char *record, const char delimiter )
 {
-	// cut off comments, don't use strtok because it will skip leading
-	// delimiters
-	{
-		char *comment;
-
-		if( (comment = strchr( record, '#' )) )
-			*comment = 0;
-	}
-
-	enum
-	{
-		Image,
-		Command,
-		Title,
-		Idle
-	};
-
-	char *fields[Idle+1];
+	Icon *icon;
 
-	bzero( fields, sizeof( fields ) );
-	fields[Image] = record;
-
-	for( int n = Image; n <= Idle; )
-	{
-		char *stop;
-
-		if( !(stop = strchr( fields[n], delimiter )) )
-			break;
-
-		*(stop++) = 0;
-		fields[++n] = stop;
-	}
-
-	if( !fields[Image] || 
-		!fields[Command] )
+	if( !(icon = Icon::parse( record, delimiter )) )
 		return false;
 
-	unsigned int idletime = Icon::Slow;
-
-	if( fields[Idle] )
-		if( !strcasecmp( fields[Idle], "fast" ) )
-			idletime = Icon::Fast;
-		else if( !strcasecmp( fields[Idle], "fastest" ) )
-			idletime = Icon::Fastest;
-		else if( !strcasecmp( fields[Idle], "slow" ) )
-			idletime = Icon::Slow;
-		else if( !strcasecmp( fields[Idle], "lame" ) )
-			idletime = Icon::Lame;
-		else 
-		{
-			unsigned int t = (unsigned int) 
-				atoi( fields[Idle] );
-
-			if( t > 0 )
-				idletime = t;
-		}
-
-	return dock.add( new Icon( fields[Image], fields[Command], 
-		(fields[Title] ? fields[Title] : ""), idletime ) );
+	return dock.add( icon );
 }
 
 /**
@@ -127,13 +75,8 @@ void loadRC( char *binary, Dock &dock )
 	rcfilename = "/."+rcfilename+"rc";
 	rcfilename = getenv( "HOME" )+rcfilename;
 
-	ifstream fin( rcfilename.c_str(), ios::in );
-
-	if( !fin )
+	if( !dock.load( rcfilename ) )
 		throw "Unable to open resource configuraton file for reading";
-
-	for( string buf; getline( fin, buf ); )
-		add( dock, (char *) buf.c_str(), ':' );
 }
 
 /**
@@ -142,6 +85,7 @@ void loadRC( char *binary, Dock &dock )
 int main( int argc, char **argv )
 {
 	Dock::Settings settings;
+	string changes;
 	char *binary;
 
 	// process command line arguments  
@@ -158,10 +102,12 @@ int main( int argc, char **argv )
 				case '?':
 				case 'h':
 					cout << "usage: " << binary << 
-" [-hvdmprlcix] IMAGEFILE:COMMAND[:WINDOWTITLE;...[:IDLE]]...\n\
+" [-hvdSmprlcaixs] IMAGEFILE:COMMAND[:WINDOWTITLE;...[:IDLE[:PRELAUNCH]]]...\n\
   -h                    print this help\n\
   -v                    print version\n\
   -d WIDTHxHEIGHT       outer dimensions of dock buttons\n\
+  -S FACTOR             scale dock buttons and icons by FACTOR, default is\n\
+                        Xft.dpi/96 or 1 if Xft.dpi is not set\n\
   -m TYPE               define look of mark indicating a running instance,\n\
                         TYPE may be \"play\", \"dots\", \"corner\" or\n\
                         \"cross\" (default)\n\
@@ -178,8 +124,32 @@ int main( int argc, char **argv )
                         already activated, use the same ACTIONs like before,\n\
                         \"nothing\" is default\n\
   -c                    match WINDOWTITLE case-sensitive (recommended)\n\
-  -i COMMAND:IMAGEFILE  remotely exchange icon of this command\n\
+  -a                    let a running compositor blend icons with what is\n\
+                        behind them instead of drawing them on a copy of\n\
+                        the background; only works if the dock buttons are\n\
+                        top-level windows or end up in a 32 bit parent,\n\
+                        slits of most window managers show black boxes\n\
+  -i COMMAND:IMAGEFILE  remotely exchange icon of this command, may be given\n\
+                        multiple times to change many icons at once\n\
   -x COMMAND            remotely execute icon with this command\n\
+                        (remotely, COMMAND may also be #ID where ID is the\n\
+                        number of the icon in order of appearance from 0)\n\
+  -s                    pass control commands from standard input to the\n\
+                        running instance and print a reply for each, valid\n\
+                        commands are \"icon COMMAND:IMAGEFILE\",\n\
+                        \"exec COMMAND\" and \"state\" which prints a\n\
+                        line per icon with tab-separated fields: slot,\n\
+                        id, pid, state, fading, windows, renders, draws\n\
+                        and command; \"stats\" prints the latencies of\n\
+                        launches per icon from the click until the\n\
+                        process got spawned, its window appeared and\n\
+                        got activated as tab-separated fields: stats, id,\n\
+                        stage, count, min, max and a comma-separated\n\
+                        histogram where the Nth number counts launches\n\
+                        that took 2^N to 2^(N+1) microseconds; after\n\
+                        \"subscribe\" there is an \"event\" line for every\n\
+                        launch, failed launch, exit, focus, icon change\n\
+                        and redraw of an icon\n\
 \n\
 IMAGEFILE   - should be path and filename of some PNG icon\n\
 COMMAND     - a script or binary to execute\n\
@@ -192,7 +162,10 @@ WINDOWTITLE - is a semicolon-seperated list of case-insensitive window-titles\n\
               instance.\n\
 IDLE        - idle time after triggering one icon in miliseconds, instead\n\
               of using numbers you may also use the terms \"lame\" (~ 10 s),\n\
-              \"slow\" (~ 5 s), \"fast\" (~ 500 ms) or \"fastest\" (~ 250 ms)"
+              \"slow\" (~ 5 s), \"fast\" (~ 500 ms) or \"fastest\" (~ 250 ms)\n\
+PRELAUNCH   - seconds after startup (or \"now\") to launch the application\n\
+              in the background, its window gets iconified and is brought\n\
+              up by a click on the icon, requires WINDOWTITLE"
 						<< endl;
 					return 0;
 				case 'v':
@@ -215,6 +188,13 @@ IDLE        - idle time after triggering one icon in miliseconds, instead\n\
 								endl;
 					}
 					break;
+				case 'S':
+					if( --argc &&
+						atof( *(++argv) ) > 0 )
+						settings.setScale( atof( *argv ) );
+					else
+						cerr << "Missing or invalid scale factor !" << endl;
+					break;
 				case 'm':
 					if( !--argc )
 						cerr << "Missing mark type !" << endl;
@@ -314,6 +294,9 @@ IDLE        - idle time after triggering one icon in miliseconds, instead\n\
 				case 'c':
 					settings.setCaseSensitive( true );
 					break;
+				case 'a':
+					settings.setCompositing( true );
+					break;
 				case 'i':
 					{
 						char *icon;
@@ -323,8 +306,11 @@ IDLE        - idle time after triggering one icon in miliseconds, instead\n\
 							(cmd = strtok( *(++argv), ":" )) &&
 							(icon = strtok( 0, "" )) )
 						{
-							Dock::changeIcon( cmd, icon );
-							return 0;
+							// collect changes to send them at once
+							changes += cmd;
+							changes += ":";
+							changes += icon;
+							changes += "\n";
 						}
 						else
 							cerr << "Missing or invalid parameter !" << 
@@ -343,8 +329,21 @@ IDLE        - idle time after triggering one icon in miliseconds, instead\n\
 								endl;
 					}
 					break;
+				case 's':
+					if( Control::send( stdin, stdout ) )
+					{
+						cerr << "Can not connect to bbdock !" << endl;
+						return -1;
+					}
+					return 0;
 			}
 
+	if( !changes.empty() )
+	{
+		Dock::changeIcons( changes );
+		return 0;
+	}
+
 	// detach from shell
 	switch( fork() )
 	{